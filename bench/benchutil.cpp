@@ -0,0 +1,131 @@
+/**
+ * BENCHUTIL.CPP
+ * Purpose: Shared statistics and JSON output for the benchmark tools.
+ * Every benchmark produces a list of samples (one per repetition), which is
+ * summarized as mean / median / stddev / 95% confidence interval.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+// =============================================================================
+// STATISTICS
+// =============================================================================
+
+struct benchResult {
+    string name;            // e.g. "trim/1024" or "status/100000"
+    string unit;            // "ns" per operation, or "ms" per command
+    vector<double> samples;
+};
+
+struct benchSummary {
+    size_t n = 0;
+    double mean = 0, median = 0, stddev = 0, min = 0, max = 0;
+    double ciLow = 0, ciHigh = 0;   // 95% confidence interval of the mean
+};
+
+/**
+ * Two-sided 95% critical value of Student's t distribution.
+ */
+double tCritical95(size_t df) {
+    static const double table[] = {
+        0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df == 0) return 0;
+    if (df <= 30) return table[df];
+    if (df <= 60) return 2.000;
+    if (df <= 120) return 1.980;
+    return 1.960;
+}
+
+benchSummary summarize(vector<double> samples) {
+    benchSummary s;
+    s.n = samples.size();
+    if (s.n == 0) return s;
+
+    sort(samples.begin(), samples.end());
+    s.min = samples.front();
+    s.max = samples.back();
+    s.median = (s.n % 2) ? samples[s.n / 2] : (samples[s.n / 2 - 1] + samples[s.n / 2]) / 2;
+    s.mean = accumulate(samples.begin(), samples.end(), 0.0) / s.n;
+
+    double var = 0;
+    for (double x : samples) var += (x - s.mean) * (x - s.mean);
+    s.stddev = (s.n > 1) ? sqrt(var / (s.n - 1)) : 0;
+
+    double half = tCritical95(s.n - 1) * s.stddev / sqrt((double)s.n);
+    s.ciLow = s.mean - half;
+    s.ciHigh = s.mean + half;
+    return s;
+}
+
+// =============================================================================
+// OUTPUT
+// =============================================================================
+
+/**
+ * Formats a value with 4 significant digits, rescaling time units for readability.
+ */
+string formatValue(double v, const string& unit) {
+    static const char* timeUnits[] = {"ns", "us", "ms", "s"};
+    int u = -1;
+    for (int i = 0; i < 4; i++) if (unit == timeUnits[i]) u = i;
+
+    while (u >= 0 && u < 3 && fabs(v) >= 1000) { v /= 1000; u++; }
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.4g%s", v, u >= 0 ? timeUnits[u] : unit.c_str());
+    return buf;
+}
+
+void printSummaryHeader() {
+    printf("%-36s %11s %11s %11s %25s %5s\n", "benchmark", "median", "mean", "stddev", "95% CI of mean", "n");
+}
+
+void printSummary(const benchResult& r) {
+    benchSummary s = summarize(r.samples);
+    string ci = "[" + formatValue(s.ciLow, r.unit) + ", " + formatValue(s.ciHigh, r.unit) + "]";
+    printf("%-36s %11s %11s %11s %25s %5zu\n", r.name.c_str(), formatValue(s.median, r.unit).c_str(),
+           formatValue(s.mean, r.unit).c_str(), formatValue(s.stddev, r.unit).c_str(), ci.c_str(), s.n);
+    fflush(stdout);
+}
+
+string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+/**
+ * Writes results as {"benchmarks":[{"name":..,"unit":..,"samples":[..]}, ...]}.
+ */
+void writeJson(const string& path, const vector<benchResult>& results) {
+    ofstream out(path, ios::trunc);
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const benchResult& r = results[i];
+        out << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"unit\": \"" << jsonEscape(r.unit)
+            << "\", \"samples\": [";
+        char num[32];
+        for (size_t j = 0; j < r.samples.size(); j++) {
+            snprintf(num, sizeof(num), "%.6g", r.samples[j]);
+            out << (j ? ", " : "") << num;
+        }
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
@@ -0,0 +1,311 @@
+/**
+ * CMDBENCH.CPP
+ * Purpose: End-to-end command benchmarks. Builds a synthetic repository and
+ * times real `mygit` invocations (add, status, commit, log), so results include
+ * process startup and filesystem effects exactly as users see them.
+ *
+ * Build:  g++ -O2 -std=c++17 bench/cmdbench.cpp -o cmdbench
+ * Run:    ./cmdbench --mygit ./mygit --files 100000 --commits 50 [--cache cold] --json run.json
+ */
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sstream>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "benchutil.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// PROCESS & REPOSITORY HELPERS
+// =============================================================================
+
+struct benchContext {
+    fs::path mygit;
+    fs::path workdir;
+    unsigned threads = 0;       // 0 = let mygit decide
+};
+
+/**
+ * Runs mygit with the given arguments inside `cwd`, discarding its output.
+ * Returns the wall-clock time in milliseconds, or -1 if it failed.
+ */
+double runMygit(const benchContext& ctx, const fs::path& cwd, const vector<string>& args) {
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (chdir(cwd.c_str()) != 0) _exit(127);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        if (ctx.threads) setenv("MYGIT_THREADS", to_string(ctx.threads).c_str(), 1);
+
+        vector<char*> argv;
+        string exe = ctx.mygit.string();
+        argv.push_back(const_cast<char*>(exe.c_str()));
+        for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(exe.c_str(), argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1;
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000.0;
+}
+
+/**
+ * Writes `files` small text files spread over directories of 100 entries.
+ */
+void writeTree(const fs::path& root, size_t files, unsigned seed) {
+    mt19937 rng(seed);
+    for (size_t i = 0; i < files; i++) {
+        fs::path dir = root / ("d" + to_string(i / 10000)) / ("s" + to_string((i / 100) % 100));
+        if (i % 100 == 0) fs::create_directories(dir);
+
+        ofstream out(dir / ("f" + to_string(i) + ".txt"));
+        int lines = 5 + rng() % 20;
+        for (int l = 0; l < lines; l++) out << "line " << l << " of file " << i << " value " << rng() << "\n";
+    }
+}
+
+fs::path treeFile(const fs::path& root, size_t i) {
+    return root / ("d" + to_string(i / 10000)) / ("s" + to_string((i / 100) % 100)) / ("f" + to_string(i) + ".txt");
+}
+
+/**
+ * Number of commits a benchmark repository holds, tracked in a marker file
+ * so repositories can be reused and grown between runs.
+ */
+size_t repoCommits(const fs::path& repo) {
+    ifstream in(repo / ".git" / "bench-commits");
+    size_t n = 0;
+    in >> n;
+    return n;
+}
+
+void setRepoCommits(const fs::path& repo, size_t n) {
+    ofstream(repo / ".git" / "bench-commits", ios::trunc) << n << "\n";
+}
+
+/**
+ * Returns a repository with `files` files and at least `commits` commits of
+ * history (the first commit adds everything; each later one modifies a single
+ * file). An existing repository is grown rather than rebuilt, so sweeping
+ * history lengths in ascending order only pays for the new commits.
+ */
+fs::path buildRepo(const benchContext& ctx, size_t files, size_t commits) {
+    fs::path repo = ctx.workdir / ("repo-" + to_string(files));
+    size_t have = repoCommits(repo);
+
+    if (have == 0 || have > commits + commits / 2 + 16) {
+        fs::remove_all(repo);
+        fs::create_directories(repo);
+        writeTree(repo, files, 42);
+
+        runMygit(ctx, repo, {"init"});
+        runMygit(ctx, repo, {"add", "."});
+        runMygit(ctx, repo, {"commit", "-m", "initial"});
+        have = 1;
+        setRepoCommits(repo, have);
+    }
+
+    for (size_t c = have; c < commits; c++) {
+        fs::path f = treeFile(repo, (c * 7919) % files);
+        { ofstream out(f, ios::app); out << "change " << c << "\n"; }
+        runMygit(ctx, repo, {"add", fs::relative(f, repo).string()});
+        runMygit(ctx, repo, {"commit", "-m", "change " + to_string(c)});
+        if (c % 100 == 0) setRepoCommits(repo, c + 1);
+    }
+    setRepoCommits(repo, max(have, commits));
+    return repo;
+}
+
+// =============================================================================
+// PAGE CACHE CONTROL
+// Cold runs evict everything the command will touch before each repetition.
+// As root the whole page cache (including dentries and inodes) is dropped;
+// otherwise each file's cached pages are discarded with posix_fadvise, which
+// leaves directory metadata cached but still forces every content read to disk.
+// =============================================================================
+
+enum cacheMode { CACHE_WARM, CACHE_COLD, CACHE_BOTH };
+
+bool dropSystemCaches() {
+    sync();
+    ofstream drop("/proc/sys/vm/drop_caches");
+    if (!drop.is_open()) return false;
+    drop << "3\n";
+    drop.flush();
+    return drop.good();
+}
+
+void evictFile(const fs::path& p) {
+    int fd = open(p.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);                                      // Dirty pages cannot be dropped
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/**
+ * Evicts the repository (work tree and .git) and the mygit binary from the
+ * page cache. Returns the method used, for the report.
+ */
+string evictCaches(const benchContext& ctx, const fs::path& repo) {
+    if (dropSystemCaches()) return "drop_caches";
+
+    sync();
+    evictFile(ctx.mygit);
+    error_code ec;
+    for (auto it = fs::recursive_directory_iterator(repo, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        if (it->is_regular_file(ec)) evictFile(it->path());
+    }
+    return "fadvise";
+}
+
+// =============================================================================
+// SCENARIOS
+// =============================================================================
+
+/**
+ * Times one scenario `reps` times. `prepare` runs untimed before each repetition.
+ */
+benchResult timeScenario(const string& name, int reps, const function<void()>& prepare,
+                         const function<double()>& timed) {
+    benchResult r{name, "ms", {}};
+    for (int i = 0; i < reps; i++) {
+        if (prepare) prepare();
+        double ms = timed();
+        if (ms >= 0) r.samples.push_back(ms);
+    }
+    return r;
+}
+
+/**
+ * Runs the add/status/commit/log scenarios against a repository.
+ * `beforeEach` runs untimed before every timed command (e.g. to drop caches).
+ */
+vector<benchResult> runScenarios(const benchContext& ctx, const fs::path& repo, const string& suffix,
+                                 const vector<string>& scenarios, int reps,
+                                 const function<void(const fs::path&)>& beforeEach = nullptr) {
+    vector<benchResult> results;
+    size_t counter = 0;
+    auto want = [&](const string& s) { return find(scenarios.begin(), scenarios.end(), s) != scenarios.end(); };
+    auto settle = [&]() { if (beforeEach) beforeEach(repo); };
+
+    // status / add on an unchanged tree: every file is compared against HEAD
+    if (want("status")) {
+        results.push_back(timeScenario("status/" + suffix, reps, settle,
+                                       [&] { return runMygit(ctx, repo, {"status"}); }));
+    }
+    if (want("add")) {
+        results.push_back(timeScenario("add/" + suffix, reps, settle,
+                                       [&] { return runMygit(ctx, repo, {"add", "."}); }));
+    }
+    // commit of one modified file on top of the full snapshot
+    if (want("commit")) {
+        results.push_back(timeScenario("commit/" + suffix, reps, [&] {
+            fs::path f = treeFile(repo, 0);
+            { ofstream out(f, ios::app); out << "bench " << counter++ << "\n"; }
+            runMygit(ctx, repo, {"add", fs::relative(f, repo).string()});
+            settle();
+        }, [&] { return runMygit(ctx, repo, {"commit", "-m", "bench"}); }));
+        setRepoCommits(repo, repoCommits(repo) + reps);
+    }
+    if (want("log")) {
+        results.push_back(timeScenario("log/" + suffix, reps, settle,
+                                       [&] { return runMygit(ctx, repo, {"log"}); }));
+    }
+    return results;
+}
+
+vector<string> splitList(const string& s) {
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ',')) if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+// =============================================================================
+// MAIN
+// =============================================================================
+
+#ifndef CMDBENCH_NO_MAIN
+int main(int argc, char* argv[]) {
+    benchContext ctx;
+    ctx.mygit = "./mygit";
+    ctx.workdir = fs::temp_directory_path() / "mygit-cmdbench";
+    size_t files = 100000, commits = 50;
+    int reps = 10;
+    string json;
+    vector<string> scenarios = {"add", "status", "commit", "log"};
+    cacheMode cache = CACHE_WARM;
+
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        auto next = [&]() { return (i + 1 < argc) ? string(argv[++i]) : string(); };
+        if (a == "--mygit") ctx.mygit = next();
+        else if (a == "--workdir") ctx.workdir = next();
+        else if (a == "--files") files = stoull(next());
+        else if (a == "--commits") commits = max<size_t>(1, stoull(next()));
+        else if (a == "--reps") reps = max(2, stoi(next()));
+        else if (a == "--threads") ctx.threads = stoul(next());
+        else if (a == "--scenarios") scenarios = splitList(next());
+        else if (a == "--json") json = next();
+        else if (a == "--cache") {
+            string mode = next();
+            cache = (mode == "cold") ? CACHE_COLD : (mode == "both") ? CACHE_BOTH : CACHE_WARM;
+        }
+        else {
+            cerr << "Usage: cmdbench [--mygit PATH] [--workdir DIR] [--files N] [--commits N] [--reps N]\n"
+                 << "                [--threads N] [--scenarios add,status,commit,log] [--cache warm|cold|both]\n"
+                 << "                [--json out.json]" << endl;
+            return 2;
+        }
+    }
+    ctx.mygit = fs::absolute(ctx.mygit);
+    fs::create_directories(ctx.workdir);
+
+    cerr << "Building repository: " << files << " files, " << commits << " commits..." << endl;
+    fs::path repo = buildRepo(ctx, files, commits);
+
+    string suffix = to_string(files) + "files";
+    vector<benchResult> results;
+    printSummaryHeader();
+
+    if (cache != CACHE_COLD) {
+        runMygit(ctx, repo, {"status"});                // Untimed pass so the first sample is warm too
+        for (auto& r : runScenarios(ctx, repo, suffix, scenarios, reps)) {
+            printSummary(r);
+            results.push_back(r);
+        }
+    }
+    if (cache != CACHE_WARM) {
+        string method;
+        auto evict = [&](const fs::path& p) { method = evictCaches(ctx, p); };
+        for (auto& r : runScenarios(ctx, repo, "cold/" + suffix, scenarios, reps, evict)) {
+            printSummary(r);
+            results.push_back(r);
+        }
+        cerr << "Cold runs evicted caches via " << method
+             << (method == "fadvise" ? " (run as root to drop dentry/inode caches too)" : "") << endl;
+    }
+
+    if (!json.empty()) writeJson(json, results);
+    return 0;
+}
+#endif
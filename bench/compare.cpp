@@ -0,0 +1,227 @@
+/**
+ * COMPARE.CPP
+ * Purpose: Regression gate for benchmark results. Compares a baseline and a
+ * candidate JSON file (as written by microbench / cmdbench) and exits non-zero
+ * if any benchmark got slower by more than the threshold with statistical
+ * significance (Welch's t-test, 95%), is missing from the candidate, or has no
+ * samples (cmdbench drops runs that failed).
+ *
+ * Build:  g++ -O2 -std=c++17 bench/compare.cpp -o benchcompare
+ * Run:    ./benchcompare baseline.json candidate.json [--threshold 5]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cctype>
+#include "benchutil.cpp"
+
+using namespace std;
+
+// =============================================================================
+// JSON INPUT
+// Just enough of a parser for the {"benchmarks":[{name, unit, samples}]} schema.
+// =============================================================================
+
+class jsonReader {
+private:
+    string text;
+    size_t pos = 0;
+
+    void skipSpace() { while (pos < text.size() && isspace((unsigned char)text[pos])) pos++; }
+
+    bool expect(char c) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c) { pos++; return true; }
+        return false;
+    }
+
+    string readString() {
+        string s;
+        if (!expect('"')) throw runtime_error("expected string");
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\' && pos + 1 < text.size()) pos++;
+            s += text[pos++];
+        }
+        pos++;
+        return s;
+    }
+
+    double readNumber() {
+        skipSpace();
+        size_t used = 0;
+        double v = stod(text.substr(pos, 32), &used);
+        pos += used;
+        return v;
+    }
+
+    // Skips any value we do not care about
+    void skipValue() {
+        skipSpace();
+        if (pos >= text.size()) return;
+        char c = text[pos];
+        if (c == '"') { readString(); return; }
+        if (c == '{' || c == '[') {
+            char close = (c == '{') ? '}' : ']';
+            pos++;
+            if (expect(close)) return;
+            do {
+                if (c == '{') { readString(); expect(':'); }
+                skipValue();
+            } while (expect(','));
+            if (!expect(close)) throw runtime_error("unterminated container");
+            return;
+        }
+        while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']') pos++;
+    }
+
+    benchResult readBenchmark() {
+        benchResult r;
+        if (!expect('{')) throw runtime_error("expected benchmark object");
+        do {
+            string key = readString();
+            expect(':');
+            if (key == "name") r.name = readString();
+            else if (key == "unit") r.unit = readString();
+            else if (key == "samples") {
+                expect('[');
+                if (!expect(']')) {
+                    do { r.samples.push_back(readNumber()); } while (expect(','));
+                    if (!expect(']')) throw runtime_error("unterminated samples");
+                }
+            } else skipValue();
+        } while (expect(','));
+        if (!expect('}')) throw runtime_error("unterminated benchmark");
+        return r;
+    }
+
+public:
+    explicit jsonReader(const string& path) {
+        ifstream in(path);
+        if (!in.is_open()) throw runtime_error("cannot open " + path);
+        stringstream ss;
+        ss << in.rdbuf();
+        text = ss.str();
+    }
+
+    vector<benchResult> benchmarks() {
+        vector<benchResult> out;
+        if (!expect('{')) throw runtime_error("expected top-level object");
+        do {
+            string key = readString();
+            expect(':');
+            if (key != "benchmarks") { skipValue(); continue; }
+            expect('[');
+            if (expect(']')) continue;
+            do { out.push_back(readBenchmark()); } while (expect(','));
+            if (!expect(']')) throw runtime_error("unterminated benchmarks");
+        } while (expect(','));
+        return out;
+    }
+};
+
+// =============================================================================
+// SIGNIFICANCE
+// =============================================================================
+
+/**
+ * Welch's t-test: true if the means differ at the 95% level.
+ */
+bool significantlyDifferent(const benchSummary& a, const benchSummary& b) {
+    if (a.n < 2 || b.n < 2) return false;
+    double va = a.stddev * a.stddev / a.n, vb = b.stddev * b.stddev / b.n;
+    if (va + vb == 0) return a.mean != b.mean;
+
+    double t = fabs(a.mean - b.mean) / sqrt(va + vb);
+    double df = (va + vb) * (va + vb) / (va * va / (a.n - 1) + vb * vb / (b.n - 1));
+    return t > tCritical95((size_t)df);
+}
+
+// =============================================================================
+// MAIN
+// =============================================================================
+
+/**
+ * Parses a non-negative percentage. Returns false on anything else.
+ */
+bool parseThreshold(const string& text, double& threshold) {
+    size_t used = 0;
+    try { threshold = stod(text, &used); }
+    catch (const exception&) { return false; }
+    return used == text.size() && threshold >= 0;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> files;
+    double threshold = 5.0;
+    bool badArgs = false;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--threshold" && i + 1 < argc) badArgs |= !parseThreshold(argv[++i], threshold);
+        else files.push_back(a);
+    }
+    if (badArgs || files.size() != 2) {
+        cerr << "Usage: benchcompare baseline.json candidate.json [--threshold percent]" << endl;
+        return 2;
+    }
+
+    map<string, benchResult> baseline;
+    vector<benchResult> candidate;
+    try {
+        for (auto& r : jsonReader(files[0]).benchmarks()) baseline[r.name] = r;
+        candidate = jsonReader(files[1]).benchmarks();
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 2;
+    }
+
+    int regressions = 0, failures = 0;
+    set<string> seen;
+    printf("%-36s %11s %11s %9s  %s\n", "benchmark", "baseline", "candidate", "change", "verdict");
+    for (const auto& cand : candidate) {
+        seen.insert(cand.name);
+        auto it = baseline.find(cand.name);
+        if (it == baseline.end()) {
+            printf("%-36s %11s %11s %9s  %s\n", cand.name.c_str(), "-", "-", "-", "new");
+            continue;
+        }
+
+        // Every run of the benchmark failed on one side, so there is nothing to compare
+        if (it->second.samples.empty() || cand.samples.empty()) {
+            printf("%-36s %11s %11s %9s  %s\n", cand.name.c_str(), it->second.samples.empty() ? "-" : "ok",
+                   cand.samples.empty() ? "-" : "ok", "-", "NO SAMPLES");
+            failures++;
+            continue;
+        }
+
+        benchSummary b = summarize(it->second.samples), c = summarize(cand.samples);
+        double change = (b.mean != 0) ? (c.mean - b.mean) / b.mean * 100 : 0;
+        bool significant = significantlyDifferent(b, c);
+
+        const char* verdict = "same";
+        if (significant && change > threshold) { verdict = "REGRESSION"; regressions++; }
+        else if (significant && change < -threshold) verdict = "faster";
+        else if (significant) verdict = "within threshold";
+
+        printf("%-36s %11s %11s %+8.1f%%  %s\n", cand.name.c_str(), formatValue(b.mean, cand.unit).c_str(),
+               formatValue(c.mean, cand.unit).c_str(), change, verdict);
+    }
+
+    for (const auto& b : baseline) {
+        if (seen.count(b.first)) continue;
+        printf("%-36s %11s %11s %9s  %s\n", b.first.c_str(), "-", "-", "-", "MISSING");
+        failures++;
+    }
+
+    if (regressions || failures) {
+        if (regressions) printf("\n%d benchmark(s) regressed by more than %.1f%%.\n", regressions, threshold);
+        if (failures) printf("\n%d benchmark(s) missing or without samples.\n", failures);
+        return 1;
+    }
+    printf("\nNo significant regressions above %.1f%%.\n", threshold);
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * MICROBENCH.CPP
+ * Purpose: Microbenchmarks for the utility functions that run once per file
+ * or per commit (trim, gen_random, get_time, isIgnored, getHEAD, filesAreSame).
+ *
+ * Build:  g++ -O2 -std=c++17 bench/microbench.cpp -o microbench
+ * Run:    ./microbench [--reps N] [--filter text] [--json out.json]
+ *
+ * Each benchmark is warmed up, its batch size is calibrated so one batch takes
+ * a few milliseconds, and then N batches are timed; every batch is one sample
+ * (nanoseconds per call), summarized with a 95% confidence interval.
+ */
+
+#include <chrono>
+#include <functional>
+#include "../manager.cpp"
+#include "benchutil.cpp"
+
+using namespace std;
+
+// =============================================================================
+// HARNESS
+// =============================================================================
+
+struct benchOptions {
+    int reps = 30;
+    string filter;
+    string json;
+    chrono::milliseconds warmup{50};
+    chrono::milliseconds batchTarget{5};
+};
+
+// Keeps the compiler from discarding a computed value
+template <class T>
+inline void keep(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+double elapsedNs(chrono::steady_clock::time_point since) {
+    return (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - since).count();
+}
+
+benchResult runBench(const string& name, const benchOptions& opt, const function<void()>& body) {
+    benchResult r{name, "ns", {}};
+
+    auto start = chrono::steady_clock::now();
+    while (chrono::steady_clock::now() - start < opt.warmup) body();
+
+    // Calibrate: grow the batch until it spans the target duration
+    uint64_t batch = 1;
+    for (;;) {
+        auto t = chrono::steady_clock::now();
+        for (uint64_t i = 0; i < batch; i++) body();
+        if (elapsedNs(t) >= chrono::duration_cast<chrono::nanoseconds>(opt.batchTarget).count()) break;
+        batch *= 2;
+    }
+
+    for (int rep = 0; rep < opt.reps; rep++) {
+        auto t = chrono::steady_clock::now();
+        for (uint64_t i = 0; i < batch; i++) body();
+        r.samples.push_back(elapsedNs(t) / batch);
+    }
+    return r;
+}
+
+// =============================================================================
+// FIXTURES
+// =============================================================================
+
+string paddedText(size_t n) {
+    string core(n, 'x');
+    return "  \t\n" + core + " \r\n  ";
+}
+
+fs::path deepPath(int depth) {
+    fs::path p;
+    for (int i = 0; i < depth; i++) p /= "dir" + to_string(i);
+    return p / "file.cpp";
+}
+
+void writeFile(const fs::path& p, size_t n, char fill) {
+    ofstream out(p, ios::binary | ios::trunc);
+    string block(64 * 1024, fill);
+    for (size_t left = n; left > 0;) {
+        size_t w = min(left, block.size());
+        out.write(block.data(), w);
+        left -= w;
+    }
+}
+
+// =============================================================================
+// MAIN
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    benchOptions opt;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--reps" && i + 1 < argc) opt.reps = max(2, atoi(argv[++i]));
+        else if (a == "--filter" && i + 1 < argc) opt.filter = argv[++i];
+        else if (a == "--json" && i + 1 < argc) opt.json = argv[++i];
+        else {
+            cerr << "Usage: microbench [--reps N] [--filter text] [--json out.json]" << endl;
+            return 2;
+        }
+    }
+
+    // Run inside a scratch repository so getHEAD and filesAreSame touch real files.
+    // HEAD is seeded in the metadata store, so getHEAD measures a store read
+    fs::path scratch = fs::temp_directory_path() / ("mygit-microbench-" + to_string(getpid()));
+    fs::create_directories(scratch / ".git");
+    fs::path original = fs::current_path();
+    fs::current_path(scratch);
+    metadata().apply({{"HEAD", string("AbCdEfGh")}});
+
+    gitClass git;
+    vector<benchResult> results;
+    auto add = [&](const string& name, const function<void()>& body) {
+        if (!opt.filter.empty() && name.find(opt.filter) == string::npos) return;
+        results.push_back(runBench(name, opt, body));
+        printSummary(results.back());
+    };
+
+    printSummaryHeader();
+
+    for (size_t n : {8, 64, 1024, 16384}) {
+        string s = paddedText(n);
+        add("trim/" + to_string(n), [&] { keep(trim(s)); });
+    }
+
+    for (int n : {8, 32, 256}) {
+        add("gen_random/" + to_string(n), [&] { keep(gen_random(n)); });
+    }
+
+    add("get_time", [&] { keep(get_time()); });
+
+    for (int depth : {1, 4, 16}) {
+        fs::path p = deepPath(depth);
+        add("isIgnored/depth" + to_string(depth), [&] { keep(git.isIgnored(p)); });
+    }
+    add("isIgnored/.git", [&] { keep(git.isIgnored(fs::path(".git") / "HEAD")); });
+
+    add("getHEAD", [&] { keep(git.getHEAD()); });
+
+    for (size_t n : {size_t(1) << 10, size_t(64) << 10, size_t(1) << 20, size_t(16) << 20}) {
+        writeFile("a.bin", n, 'a');
+        writeFile("b.bin", n, 'a');
+        writeFile("c.bin", n + 1, 'a');
+        add("filesAreSame/equal/" + to_string(n), [&] { keep(filesAreSame("a.bin", "b.bin")); });
+        add("filesAreSame/sizediff/" + to_string(n), [&] { keep(filesAreSame("a.bin", "c.bin")); });
+    }
+
+    fs::current_path(original);
+    fs::remove_all(scratch);
+
+    if (!opt.json.empty()) writeJson(opt.json, results);
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * STORAGEBENCH.CPP
+ * Purpose: Compares the snapshot storage backends (storage.cpp) on identical
+ * workloads. Every backend builds the same synthetic history in its own
+ * scratch repository, through the same writeSnapshot path the commit command
+ * uses, and then serves the same lookups from the newest snapshot.
+ *
+ * Build:  g++ -O2 -std=c++17 bench/storagebench.cpp -o storagebench -lpthread
+ * Run:    ./storagebench [--files N] [--commits N] [--changes N] [--size bytes]
+ *                        [--reps N] [--backends copy,hardlink,loose,segment] [--json out.json]
+ *
+ * Reported per backend: milliseconds per commit (one sample per commit after
+ * the initial one), and per repetition the time to list the newest snapshot,
+ * to answer exists() for every path (ns per call) and to get() and read every
+ * file. Lookups are warmed once first, so blobs a backend extracts on first
+ * use are not counted. Disk usage (hard links counted once) is printed last.
+ */
+
+#include <chrono>
+#include <random>
+#include <iomanip>
+#include <sstream>
+#include "../manager.cpp"
+#include "benchutil.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+struct storageOptions {
+    size_t files = 10000;
+    size_t commits = 20;
+    size_t changes = 100;
+    size_t size = 4096;
+    int reps = 10;
+    string backends = "copy,hardlink,loose,segment";
+    string json;
+};
+
+double elapsedMs(chrono::steady_clock::time_point since) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - since).count();
+}
+
+// =============================================================================
+// WORKLOAD
+// Seeded, so every backend sees exactly the same files and edits.
+// =============================================================================
+
+string filePath(size_t i) {
+    return "d" + to_string(i % 64) + "/f" + to_string(i) + ".txt";
+}
+
+void writeContent(const fs::path& p, size_t size, mt19937_64& rng) {
+    fs::create_directories(p.parent_path());
+    string content(size, '\0');
+    for (auto& c : content) c = (char)('a' + rng() % 26);
+    ofstream(p, ios::binary | ios::trunc).write(content.data(), (streamsize)content.size());
+}
+
+string commitName(size_t i) {
+    ostringstream s;
+    s << "c" << setw(7) << setfill('0') << i;
+    return s.str();
+}
+
+// =============================================================================
+// BACKEND RUN
+// =============================================================================
+
+template <class Backend>
+void benchBackend(const string& name, const storageOptions& opt, vector<benchResult>& results) {
+    mt19937_64 rng(42);
+    fs::path work = fs::current_path() / "work";
+
+    treeDelta initial;
+    for (size_t i = 0; i < opt.files; i++) {
+        writeContent(work / filePath(i), opt.size, rng);
+        initial.changed.push_back({filePath(i), work / filePath(i)});
+    }
+    sort(initial.changed.begin(), initial.changed.end());
+    {
+        Backend store;
+        writeSnapshot(store, commitName(0), "", initial, false);
+    }
+
+    benchResult commit{name + "/commit", "ms", {}};
+    for (size_t c = 1; c < opt.commits; c++) {
+        treeDelta delta;
+        set<size_t> picked;
+        while (picked.size() < min(opt.changes, opt.files)) picked.insert(rng() % opt.files);
+        for (size_t i : picked) {
+            writeContent(work / filePath(i), opt.size, rng);
+            delta.changed.push_back({filePath(i), work / filePath(i)});
+        }
+        auto start = chrono::steady_clock::now();
+        Backend store;
+        writeSnapshot(store, commitName(c), commitName(c - 1), delta, false);
+        commit.samples.push_back(elapsedMs(start));
+    }
+
+    string head = commitName(max<size_t>(opt.commits, 1) - 1);
+    vector<string> paths;
+    for (const auto& t : Backend().list(head)) paths.push_back(t.first);
+
+    benchResult list{name + "/list", "ms", {}}, exists{name + "/exists", "ns", {}}, get{name + "/get+read", "ms", {}};
+    for (int r = 0; r < opt.reps; r++) {
+        auto start = chrono::steady_clock::now();
+        Backend().list(head);
+        list.samples.push_back(elapsedMs(start));
+
+        Backend store;
+        size_t found = 0;
+        start = chrono::steady_clock::now();
+        for (const auto& p : paths) found += store.exists(head, p);
+        exists.samples.push_back(elapsedMs(start) * 1e6 / max<size_t>(paths.size(), 1));
+        if (found != paths.size()) cerr << name << ": exists() missed " << paths.size() - found << " path(s)" << endl;
+
+        vector<char> buf(1 << 16);
+        start = chrono::steady_clock::now();
+        for (const auto& p : paths) {
+            ifstream in(store.get(head, p), ios::binary);
+            while (in.read(buf.data(), buf.size())) {}
+        }
+        get.samples.push_back(elapsedMs(start));
+    }
+
+    for (auto* r : {&commit, &list, &exists, &get}) {
+        printSummary(*r);
+        results.push_back(*r);
+    }
+    cout << "  " << name << " on disk: " << formatBytes(storageBytes()) << endl;
+}
+
+int main(int argc, char* argv[]) {
+    storageOptions opt;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--files" && i + 1 < argc) opt.files = max(1, atoi(argv[++i]));
+        else if (a == "--commits" && i + 1 < argc) opt.commits = max(2, atoi(argv[++i]));
+        else if (a == "--changes" && i + 1 < argc) opt.changes = max(1, atoi(argv[++i]));
+        else if (a == "--size" && i + 1 < argc) opt.size = (size_t)atoll(argv[++i]);
+        else if (a == "--reps" && i + 1 < argc) opt.reps = max(2, atoi(argv[++i]));
+        else if (a == "--backends" && i + 1 < argc) opt.backends = argv[++i];
+        else if (a == "--json" && i + 1 < argc) opt.json = argv[++i];
+        else {
+            cerr << "Usage: storagebench [--files N] [--commits N] [--changes N] [--size bytes] [--reps N]"
+                 << " [--backends copy,hardlink,loose,segment] [--json out.json]" << endl;
+            return 2;
+        }
+    }
+
+    fs::path scratch = fs::temp_directory_path() / ("mygit-storagebench-" + to_string(getpid()));
+    fs::path original = fs::current_path();
+    vector<benchResult> results;
+    printSummaryHeader();
+
+    // Each backend gets a fresh repository, so none benefits from another's page cache state
+    auto run = [&](const string& name, void (*bench)(const string&, const storageOptions&, vector<benchResult>&)) {
+        if (("," + opt.backends + ",").find("," + name + ",") == string::npos) return;
+        fs::create_directories(scratch / name / ".git" / "commits");
+        fs::current_path(scratch / name);
+        bench(name, opt, results);
+        fs::current_path(original);
+        fs::remove_all(scratch / name);
+    };
+    run("copy", benchBackend<legacyCopyBackend>);
+    run("hardlink", benchBackend<hardlinkBackend>);
+    run("loose", benchBackend<looseObjectBackend>);
+    run("segment", benchBackend<segmentBackend>);
+    fs::remove_all(scratch);
+
+    if (!opt.json.empty()) writeJson(opt.json, results);
+    return 0;
+}
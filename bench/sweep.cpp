@@ -0,0 +1,146 @@
+/**
+ * SWEEP.CPP
+ * Purpose: Scaling curves. Runs the command benchmarks across a grid of
+ * repository sizes, history lengths and thread counts, writes every point as
+ * CSV for plotting, and fits a log-log slope per curve (slope < 1 means the
+ * command scales sub-linearly along that axis).
+ *
+ * Build:  g++ -O2 -std=c++17 bench/sweep.cpp -o sweep
+ * Run:    ./sweep --mygit ./mygit --files 1000,10000,100000 --commits 10,100,1000 \
+ *                 --threads 1,4 --csv scaling.csv
+ */
+
+#define CMDBENCH_NO_MAIN
+#include "cmdbench.cpp"
+#include <map>
+#include <tuple>
+
+using namespace std;
+
+// =============================================================================
+// GRID RESULTS
+// =============================================================================
+
+struct sweepPoint {
+    string scenario;
+    size_t files, commits;
+    unsigned threads;
+    benchSummary summary;
+};
+
+vector<size_t> parseSizes(const string& s) {
+    vector<size_t> out;
+    for (const auto& item : splitList(s)) out.push_back(stoull(item));
+    sort(out.begin(), out.end());
+    return out;
+}
+
+/**
+ * Least-squares slope of log(median) against log(x).
+ */
+double logLogSlope(const vector<pair<double, double>>& xy) {
+    if (xy.size() < 2) return NAN;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (auto [x, y] : xy) {
+        double lx = log(x), ly = log(y);
+        sx += lx; sy += ly; sxx += lx * lx; sxy += lx * ly;
+    }
+    double n = xy.size(), denom = n * sxx - sx * sx;
+    return denom == 0 ? NAN : (n * sxy - sx * sy) / denom;
+}
+
+void writeCsv(const string& path, const vector<sweepPoint>& points) {
+    ofstream out(path, ios::trunc);
+    out << "scenario,files,commits,threads,n,median_ms,mean_ms,stddev_ms,ci_low_ms,ci_high_ms\n";
+    for (const auto& p : points) {
+        const benchSummary& s = p.summary;
+        out << p.scenario << ',' << p.files << ',' << p.commits << ',' << p.threads << ',' << s.n << ','
+            << s.median << ',' << s.mean << ',' << s.stddev << ',' << s.ciLow << ',' << s.ciHigh << '\n';
+    }
+}
+
+/**
+ * Prints one slope per curve: each scenario along files (history and threads
+ * fixed), and along commits (size and threads fixed).
+ */
+void printSlopes(const vector<sweepPoint>& points) {
+    map<tuple<string, size_t, unsigned>, vector<pair<double, double>>> byFiles, byCommits;
+    for (const auto& p : points) {
+        if (p.summary.n == 0 || p.summary.median <= 0) continue;
+        byFiles[{p.scenario, p.commits, p.threads}].push_back({(double)p.files, p.summary.median});
+        byCommits[{p.scenario, p.files, p.threads}].push_back({(double)p.commits, p.summary.median});
+    }
+
+    printf("\n%-10s %-8s %-22s %8s\n", "scenario", "axis", "fixed", "slope");
+    for (const auto& [key, xy] : byFiles) {
+        if (xy.size() < 2) continue;
+        string fixed = to_string(get<1>(key)) + " commits, " + to_string(get<2>(key)) + "t";
+        printf("%-10s %-8s %-22s %8.3f\n", get<0>(key).c_str(), "files", fixed.c_str(), logLogSlope(xy));
+    }
+    for (const auto& [key, xy] : byCommits) {
+        if (xy.size() < 2) continue;
+        string fixed = to_string(get<1>(key)) + " files, " + to_string(get<2>(key)) + "t";
+        printf("%-10s %-8s %-22s %8.3f\n", get<0>(key).c_str(), "commits", fixed.c_str(), logLogSlope(xy));
+    }
+}
+
+// =============================================================================
+// MAIN
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    benchContext ctx;
+    ctx.mygit = "./mygit";
+    ctx.workdir = fs::temp_directory_path() / "mygit-cmdbench";
+    vector<size_t> fileCounts = {1000, 10000, 100000};
+    vector<size_t> commitCounts = {10, 100, 1000};
+    vector<size_t> threadCounts = {0};
+    vector<string> scenarios = {"add", "status", "commit", "log"};
+    int reps = 5;
+    string csv = "scaling.csv";
+
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        auto next = [&]() { return (i + 1 < argc) ? string(argv[++i]) : string(); };
+        if (a == "--mygit") ctx.mygit = next();
+        else if (a == "--workdir") ctx.workdir = next();
+        else if (a == "--files") fileCounts = parseSizes(next());
+        else if (a == "--commits") commitCounts = parseSizes(next());
+        else if (a == "--threads") threadCounts = parseSizes(next());
+        else if (a == "--scenarios") scenarios = splitList(next());
+        else if (a == "--reps") reps = max(2, stoi(next()));
+        else if (a == "--csv") csv = next();
+        else {
+            cerr << "Usage: sweep [--mygit PATH] [--workdir DIR] [--files N,N..] [--commits N,N..]\n"
+                 << "             [--threads N,N..] [--scenarios add,status,commit,log] [--reps N] [--csv out.csv]" << endl;
+            return 2;
+        }
+    }
+    ctx.mygit = fs::absolute(ctx.mygit);
+    fs::create_directories(ctx.workdir);
+
+    vector<sweepPoint> points;
+    printSummaryHeader();
+    for (size_t files : fileCounts) {
+        // Ascending history lengths grow one repository instead of rebuilding it
+        for (size_t commits : commitCounts) {
+            cerr << "Preparing repository: " << files << " files, " << commits << " commits..." << endl;
+            fs::path repo = buildRepo(ctx, files, commits);
+
+            for (size_t threads : threadCounts) {
+                ctx.threads = (unsigned)threads;
+                string suffix = to_string(files) + "f/" + to_string(commits) + "c/" + to_string(threads) + "t";
+                for (const auto& r : runScenarios(ctx, repo, suffix, scenarios, reps)) {
+                    printSummary(r);
+                    points.push_back({r.name.substr(0, r.name.find('/')), files, commits,
+                                      (unsigned)threads, summarize(r.samples)});
+                }
+                writeCsv(csv, points);      // Keep partial results if a long sweep is interrupted
+            }
+        }
+    }
+
+    printSlopes(points);
+    cerr << "Wrote " << points.size() << " points to " << csv << endl;
+    return 0;
+}
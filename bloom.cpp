@@ -0,0 +1,131 @@
+/**
+ * BLOOM.CPP
+ * Purpose: Negative lookup cache. A Bloom filter answers "is this key
+ * definitely absent?" from memory, so most lookups for paths a commit does
+ * not contain never reach the filesystem. Filters can be saved next to the
+ * data they describe and are rebuilt whenever a saved copy is unusable.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "crc32c.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// ON-DISK FORMAT
+//   "MYBLOOM1" | u32 hash count | u64 bit count | u64 words[bit count / 64]
+//   | u32 CRC32C
+// =============================================================================
+
+const char BLOOM_MAGIC[8] = {'M', 'Y', 'B', 'L', 'O', 'O', 'M', '1'};
+const uint64_t BLOOM_BITS_PER_KEY = 10;     // ~1% false positives with 7 hashes
+const uint32_t BLOOM_HASHES = 7;
+
+class bloomFilter {
+private:
+    vector<uint64_t> words;
+    uint64_t bits = 0;
+    uint32_t hashes = BLOOM_HASHES;
+
+    /**
+     * FNV-1a folded through a 64-bit finalizer; the two halves drive the
+     * double hashing that derives all probe positions.
+     */
+    static uint64_t keyHash(string_view key) {
+        uint64_t h = 1469598103934665603ull;
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27; h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        return h;
+    }
+
+public:
+    explicit bloomFilter(uint64_t expectedKeys = 0) {
+        bits = max<uint64_t>(64, expectedKeys * BLOOM_BITS_PER_KEY);
+        words.assign((bits + 63) / 64, 0);
+        bits = words.size() * 64;
+    }
+
+    void add(string_view key) {
+        uint64_t h = keyHash(key), step = (h >> 32) | 1;
+        for (uint32_t i = 0; i < hashes; i++, h += step) {
+            uint64_t bit = h % bits;
+            words[bit / 64] |= 1ull << (bit % 64);
+        }
+    }
+
+    /**
+     * False means the key was never added; true means it probably was.
+     */
+    bool possiblyContains(string_view key) const {
+        uint64_t h = keyHash(key), step = (h >> 32) | 1;
+        for (uint32_t i = 0; i < hashes; i++, h += step) {
+            uint64_t bit = h % bits;
+            if (!(words[bit / 64] & (1ull << (bit % 64)))) return false;
+        }
+        return true;
+    }
+
+    bool save(const fs::path& p) const {
+        uint64_t count = words.size();
+        uint32_t crc = crc32c(BLOOM_MAGIC, 8);
+        crc = crc32c(&hashes, sizeof(hashes), crc);
+        crc = crc32c(&bits, sizeof(bits), crc);
+        crc = crc32c(words.data(), count * sizeof(uint64_t), crc);
+
+        fs::path tmp = p;
+        tmp += ".tmp";
+        {
+            ofstream out(tmp, ios::binary | ios::trunc);
+            if (!out.is_open()) return false;
+            out.write(BLOOM_MAGIC, 8);
+            out.write(reinterpret_cast<const char*>(&hashes), sizeof(hashes));
+            out.write(reinterpret_cast<const char*>(&bits), sizeof(bits));
+            out.write(reinterpret_cast<const char*>(words.data()), (streamsize)(count * sizeof(uint64_t)));
+            out.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+            if (!out) return false;
+        }
+        error_code ec;
+        fs::rename(tmp, p, ec);
+        return !ec;
+    }
+
+    /**
+     * Returns false (leaving the filter unchanged) if the file is missing or
+     * damaged; callers then rebuild it from the source data.
+     */
+    bool load(const fs::path& p) {
+        ifstream in(p, ios::binary);
+        string raw((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        const size_t header = 8 + sizeof(uint32_t) + sizeof(uint64_t);
+        if (raw.size() < header + sizeof(uint32_t) || memcmp(raw.data(), BLOOM_MAGIC, 8) != 0) return false;
+
+        uint32_t k, crc;
+        uint64_t n;
+        memcpy(&k, raw.data() + 8, sizeof(k));
+        memcpy(&n, raw.data() + 12, sizeof(n));
+        size_t payload = raw.size() - sizeof(crc);
+        memcpy(&crc, raw.data() + payload, sizeof(crc));
+        if (k == 0 || n == 0 || n % 64 != 0 || payload - header != n / 8) return false;
+        if (crc32c(raw.data(), payload) != crc) return false;
+
+        hashes = k;
+        bits = n;
+        words.resize(n / 64);
+        memcpy(words.data(), raw.data() + header, payload - header);
+        return true;
+    }
+};
@@ -0,0 +1,74 @@
+/**
+ * CONFIG.CPP
+ * Purpose: Reads repository settings from .git/config ("key = value" lines,
+ * '#' starts a comment). Missing keys fall back to built-in defaults.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+using namespace std;
+
+/**
+ * Returns the value stored for `key`, or `fallback` if it is not set.
+ */
+string configValue(const string& key, const string& fallback) {
+    ifstream file(".git/config");
+    string line;
+    while (getline(file, line)) {
+        size_t eq = line.find('=');
+        if (line.empty() || line[0] == '#' || eq == string::npos) continue;
+
+        string k = line.substr(0, eq), v = line.substr(eq + 1);
+        k.erase(0, k.find_first_not_of(" \t"));
+        k.erase(k.find_last_not_of(" \t\r") + 1);
+        v.erase(0, v.find_first_not_of(" \t"));
+        v.erase(v.find_last_not_of(" \t\r") + 1);
+        if (k == key) return v;
+    }
+    return fallback;
+}
+
+/**
+ * Parses a byte size such as "4096", "64K", "512M" or "2G".
+ * Returns `fallback` if the text is not a valid size.
+ */
+uint64_t parseSize(const string& text, uint64_t fallback) {
+    size_t used = 0;
+    uint64_t n;
+    try { n = stoull(text, &used); }
+    catch (const exception&) { return fallback; }
+
+    string unit = text.substr(used);
+    if (unit.empty() || unit == "B") return n;
+    if (unit == "K" || unit == "KB") return n << 10;
+    if (unit == "M" || unit == "MB") return n << 20;
+    if (unit == "G" || unit == "GB") return n << 30;
+    return fallback;
+}
+
+uint64_t configSize(const string& key, uint64_t fallback) {
+    return parseSize(configValue(key, ""), fallback);
+}
+
+/**
+ * Number of worker threads for parallel work: MYGIT_THREADS, then
+ * "core.threads", then the hardware concurrency.
+ */
+unsigned workerThreads() {
+    static unsigned threads = [] {
+        const char* env = getenv("MYGIT_THREADS");
+        string v = env ? string(env) : configValue("core.threads", "");
+        unsigned n = 0;
+        try { n = v.empty() ? 0 : (unsigned)stoul(v); }
+        catch (const exception&) { n = 0; }
+        if (n == 0) n = thread::hardware_concurrency();
+        return n == 0 ? 1u : n;
+    }();
+    return threads;
+}
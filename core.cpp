@@ -11,7 +11,19 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <map>
+#include <set>
+#include <functional>
+#include <sstream>
 #include <unistd.h>
+#include "reflog.cpp"
+#include "largefile.cpp"
+#include "segments.cpp"
+#include "storage.cpp"
+#include "crc32c.cpp"
+#include "metastore.cpp"
+#include "bloom.cpp"
+#include "readahead.cpp"
 
 // Terminal Colors
 #define RED "\x1B[31m"
@@ -68,6 +80,359 @@ string trim(string s) {
     return s;
 }
 
+/**
+ * Performs a binary comparison between two files to check if they are identical.
+ * A large-file pointer compares equal to the content it refers to.
+ */
+bool filesAreSame(const fs::path &a, const fs::path &b) {
+    // file_size fails for missing paths, so one stat per file covers existence too
+    error_code ecA, ecB;
+    uintmax_t sizeA, sizeB;
+    {
+        latencyTimer t(LAT_STAT);
+        sizeA = fs::file_size(a, ecA);
+    }
+    {
+        latencyTimer t(LAT_STAT);
+        sizeB = fs::file_size(b, ecB);
+    }
+    if (ecA || ecB) return false;
+
+    if (sizeA != sizeB) {
+        largePointer ptr;
+        if (readLargePointer(a, ptr)) return matchesLargePointer(b, ptr);
+        if (readLargePointer(b, ptr)) return matchesLargePointer(a, ptr);
+        return false;
+    }
+
+    ifstream fa, fb;
+    {
+        latencyTimer t(LAT_OPEN);
+        fa.open(a, ios::binary);
+        fb.open(b, ios::binary);
+    }
+
+    latencyTimer t(LAT_READ);
+    return equal(
+        istreambuf_iterator<char>(fa),
+        istreambuf_iterator<char>(),
+        istreambuf_iterator<char>(fb)
+    );
+}
+
+// =============================================================================
+// REFERENCES & METADATA
+// =============================================================================
+
+/**
+ * Reads the current HEAD commit ID. Returns an empty string if no commit exists.
+ */
+string readHEAD() {
+    string id;
+    if (!metadata().get("HEAD", id)) return "";
+    return (id == "NULL") ? "" : id;
+}
+
+/**
+ * Points HEAD at the given commit ID (empty string means no commit)
+ * and records the move in the reflog.
+ */
+void writeHEAD(const string& id, reflogOp op) {
+    string oldID = readHEAD();
+    metadata().put("HEAD", id.empty() ? "NULL" : id);
+
+    reflog().append(oldID.empty() ? "NULL" : oldID, id.empty() ? "NULL" : id, op);
+}
+
+/**
+ * Parsed metadata record of a commit (formerly its commitInfo.txt file).
+ */
+struct commitInfo {
+    string id;
+    string parent;      // Empty for the root commit
+    string msg;
+    string time;
+};
+
+/**
+ * Loads the metadata of a commit. Returns false if the commit does not exist.
+ */
+bool readCommitInfo(const string& id, commitInfo& info) {
+    if (id.empty()) return false;
+    memScope phase(PHASE_METADATA, "readCommitInfo");
+    string content;
+    if (!metadata().get("commit/" + id, content)) return false;
+
+    info = commitInfo();
+    istringstream file(content);
+    string line;
+    while (getline(file, line)) {
+        if (line.size() < 2) continue;
+        switch (line[0]) {
+            case '1': info.id = trim(line.substr(2)); break;
+            case '2': info.parent = trim(line.substr(2)); break;
+            case '3': info.msg = line.substr(2); break;
+            case '4': info.time = line.substr(2); break;
+        }
+    }
+    if (info.parent == "NULL") info.parent = "";
+    return true;
+}
+
+/**
+ * Stores the metadata record of a commit.
+ */
+void writeCommitInfo(const commitInfo& info) {
+    ostringstream file;
+    file << "1." << info.id << "\n";
+    file << "2." << (info.parent.empty() ? "NULL" : info.parent) << "\n";
+    file << "3." << info.msg << "\n";
+    file << "4." << info.time << "\n";
+    metadata().put("commit/" + info.id, file.str());
+}
+
+/**
+ * Adds the erasure of a commit's metadata record and change list to a batch.
+ */
+void eraseCommitInfo(const string& id, metaTable& changes) {
+    changes["commit/" + id] = nullopt;
+    changes["changes/" + id] = nullopt;
+}
+
+/**
+ * Drops the metadata records and change lists of commits whose directories
+ * were deleted.
+ */
+void eraseCommitInfo(const vector<string>& ids) {
+    metaTable changes;
+    for (const auto& id : ids) eraseCommitInfo(id, changes);
+    if (!changes.empty()) metadata().apply(changes);
+}
+
+/**
+ * Resolves "HEAD", "HEAD~N", "HEAD@{N}" (Nth previous HEAD from the reflog)
+ * or a raw commit ID to an existing commit ID.
+ * Returns an empty string if the revision does not name a commit.
+ */
+string resolveRevision(const string& rev) {
+    string id = rev;
+    int back = 0;
+
+    if (rev.compare(0, 5, "HEAD@") == 0) {
+        uint64_t n;
+        if (rev.size() < 8 || rev[5] != '{' || rev.back() != '}') return "";
+        try { n = stoull(rev.substr(6, rev.size() - 7)); }
+        catch (const exception&) { return ""; }
+
+        reflog log;
+        reflog::entry e;
+        if (n >= log.size() || !log.read(log.size() - 1 - n, e)) return "";
+        id = e.newID;
+    }
+    else if (rev.compare(0, 4, "HEAD") == 0) {
+        id = readHEAD();
+        if (rev.size() > 4) {
+            if (rev[4] != '~') return "";
+            try { back = (rev.size() == 5) ? 1 : stoi(rev.substr(5)); }
+            catch (const exception&) { return ""; }
+        }
+    }
+
+    commitInfo info;
+    if (!readCommitInfo(id, info)) return "";
+    while (back-- > 0) {
+        id = info.parent;
+        if (!readCommitInfo(id, info)) return "";
+    }
+    return id;
+}
+
+// =============================================================================
+// SNAPSHOT TREES
+// =============================================================================
+
+/**
+ * A set of path-level changes between two snapshots.
+ * `changed` holds the source of the new content for every added/modified path.
+ */
+struct treeDelta {
+    vector<pair<string, fs::path>> changed;
+    vector<string> removed;
+
+    bool empty() const { return changed.empty() && removed.empty(); }
+};
+
+/**
+ * Lists the files stored in a commit snapshot. An empty ID yields an empty tree.
+ * Files of archived or manifest-only commits are served from the object stores.
+ */
+commitTree readTree(const string& commitID) {
+    return snapshotBackend().list(commitID);
+}
+
+fs::path pathFilterPath(const string& commitID) {
+    return fs::current_path() / ".git" / "commits" / commitID / "paths.bloom";
+}
+
+/**
+ * Loads the Bloom filter over the paths of a loose commit, so callers can
+ * skip filesystem lookups for paths it certainly does not contain. Commits
+ * written before filters existed get one built and saved on first use.
+ * Returns false if the commit has no Data/ tree to describe.
+ */
+bool loadPathFilter(const string& commitID, bloomFilter& filter) {
+    if (commitID.empty()) return false;
+    fs::path dataPath = fs::current_path() / ".git" / "commits" / commitID / "Data";
+    if (!fs::exists(dataPath)) return false;
+    if (filter.load(pathFilterPath(commitID))) return true;
+
+    commitTree tree = readTree(commitID);
+    filter = bloomFilter(tree.size());
+    for (const auto& t : tree) filter.add(t.first);
+    filter.save(pathFilterPath(commitID));
+    return true;
+}
+
+/**
+ * Brings an archived commit back into the loose layout before HEAD moves to
+ * it, so add/status compare against HEAD's Data/ instead of extracted blobs.
+ * Backends that do not keep Data/ trees leave it as it is.
+ */
+void thawCommit(const string& commitID) {
+    if (!snapshotBackend::dataTrees || !isArchived(commitID)) return;
+
+    fs::path commitPath = fs::current_path() / ".git" / "commits" / commitID;
+    fs::path tmp = commitPath / "Data.thaw";
+    fs::remove_all(tmp);
+    for (const auto& t : readTree(commitID)) {
+        fs::create_directories((tmp / t.first).parent_path());
+        error_code ec;
+        fs::create_hard_link(t.second, tmp / t.first, ec);
+        if (ec) fs::copy_file(t.second, tmp / t.first, fs::copy_options::overwrite_existing);
+    }
+    fs::create_directories(tmp);
+    fs::rename(tmp, commitPath / "Data");
+}
+
+/**
+ * Records the paths a commit's delta touched ("+ path" stored, "- path"
+ * removed) under the "changes/<id>" metadata key, so replaying the commit
+ * later only looks at those paths.
+ */
+void writeChangeList(const string& commitID, const treeDelta& delta) {
+    ostringstream out;
+    for (const auto& c : delta.changed) out << "+ " << c.first << "\n";
+    for (const auto& r : delta.removed) out << "- " << r << "\n";
+    metadata().apply({{"changes/" + commitID, out.str()}});
+}
+
+bool readChangeList(const string& commitID, vector<string>& stored, vector<string>& removed) {
+    string body;
+    if (!metadata().get("changes/" + commitID, body)) return false;
+    istringstream in(body);
+    string line;
+    while (getline(in, line)) {
+        if (line.size() < 3 || line[1] != ' ') return false;
+        if (line[0] == '+') stored.push_back(line.substr(2));
+        else if (line[0] == '-') removed.push_back(line.substr(2));
+        else return false;
+    }
+    return true;
+}
+
+/**
+ * Compares two stored files. Hard-linked copies are detected without reading content.
+ */
+bool storedFilesAreSame(const fs::path &a, const fs::path &b) {
+    error_code ec;
+    if (fs::equivalent(a, b, ec)) return true;
+    return filesAreSame(a, b);
+}
+
+/**
+ * Computes the changes that turn snapshot `from` into snapshot `to`.
+ */
+treeDelta diffTrees(const commitTree& from, const commitTree& to) {
+    treeDelta delta;
+    auto f = from.begin();
+    auto t = to.begin();
+
+    // Both maps are sorted, so a single merge pass finds every difference
+    while (f != from.end() || t != to.end()) {
+        if (t == to.end() || (f != from.end() && f->first < t->first)) {
+            delta.removed.push_back(f->first);
+            ++f;
+        } else if (f == from.end() || t->first < f->first) {
+            delta.changed.push_back(*t);
+            ++t;
+        } else {
+            if (!storedFilesAreSame(f->second, t->second)) delta.changed.push_back(*t);
+            ++f; ++t;
+        }
+    }
+    return delta;
+}
+
+/**
+ * Copies a stored file byte-for-byte between storage areas (pointers stay pointers).
+ */
+void copyVerbatim(const fs::path& stored, const fs::path& dst) {
+    fs::create_directories(dst.parent_path());
+    fs::copy_file(stored, dst, fs::copy_options::overwrite_existing);
+}
+
+/**
+ * Copies a stored snapshot file out to a destination (e.g. the working tree).
+ * Large-file pointers are expanded from the large-object area.
+ */
+void restoreFile(const fs::path& stored, const fs::path& dst) {
+    fs::create_directories(dst.parent_path());
+
+    largePointer ptr;
+    fs::path src = readLargePointer(stored, ptr) ? largeObjectPath(ptr.hash) : stored;
+    fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
+}
+
+/**
+ * Writes the snapshot of commit `commitID`: the parent's files, overlaid with
+ * `delta`, stored through `Backend`. Data/ trees also get the path filter
+ * used by add/status (manifest lookups are already in memory).
+ * `linkSources` allows delta sources to be shared instead of copied.
+ */
+template <class Backend>
+void writeSnapshot(Backend& store, const string& commitID, const string& parentID,
+                   const treeDelta& delta, bool linkSources) {
+    set<string> touched;
+    for (const auto &c : delta.changed) touched.insert(c.first);
+    for (const auto &r : delta.removed) touched.insert(r);
+
+    // 1. INHERIT: Unchanged files of the parent commit (Snapshotting)
+    vector<string> paths = store.commit(commitID, parentID, touched);
+
+    // 2. OVERLAY: Apply the new changes on top of the inherited snapshot
+    {
+        memScope phase(PHASE_COPY, "createCommit");
+        vector<fs::path> sources;
+        if (!linkSources) for (const auto &c : delta.changed) sources.push_back(c.second);
+        prefetcher ahead(move(sources), PREFETCH_DATA, PREFETCH_WINDOW);
+        for (size_t i = 0; i < delta.changed.size(); i++) {
+            const auto &c = delta.changed[i];
+            ahead.consumed(i);
+            store.put(commitID, c.first, c.second, linkSources);
+            paths.push_back(c.first);
+        }
+    }
+
+    // 3. SEAL: Make the snapshot durable; Data/ trees also get a path filter
+    memScope metadata(PHASE_METADATA, "createCommit");
+    store.seal(commitID);
+    writeChangeList(commitID, delta);
+    if (!Backend::dataTrees) return;
+    bloomFilter filter(paths.size());
+    for (const auto &p : paths) filter.add(p);
+    filter.save(pathFilterPath(commitID));
+}
+
 // =============================================================================
 // COMMIT NODE CLASS
 // Represents a single point in history.
@@ -82,62 +447,45 @@ private:
 public:
     commitNode(string id, string parent, string msg)
         : commitID(id), parentCommitID(parent), commitMsg(msg) {
-        createCommit();
+        createCommit(stagedChanges(), false);
     }
 
     /**
-     * Physically creates the commit directory and handles file snapshots.
+     * Creates a commit from an explicit delta against the parent snapshot.
+     * Delta sources must be immutable snapshot files (used when replaying history).
      */
-    void createCommit() {
-        try {
-            fs::path commitsRoot = fs::current_path() / ".git" / "commits";
-            fs::path commitPath = commitsRoot / commitID;
-            fs::path dataPath = commitPath / "Data";
-
-            fs::create_directories(dataPath);
-
-            // 1. INHERIT: Copy files from the parent commit (Snapshotting)
-            if (!parentCommitID.empty()) {
-                fs::path parentData = commitsRoot / parentCommitID / "Data";
-                if (fs::exists(parentData)) {
-                    for (const auto &e : fs::recursive_directory_iterator(parentData)) {
-                        if (fs::is_regular_file(e.path())) {
-                            fs::path rel = fs::relative(e.path(), parentData);
-                            fs::path dst = dataPath / rel;
-                            fs::create_directories(dst.parent_path());
-                            
-                            // Ensure clean copy
-                            if (fs::exists(dst)) fs::remove(dst);
-                            fs::copy_file(e.path(), dst);
-                        }
-                    }
-                }
-            }
+    commitNode(string id, string parent, string msg, const treeDelta& delta)
+        : commitID(id), parentCommitID(parent), commitMsg(msg) {
+        createCommit(delta, true);
+    }
 
-            // 2. OVERLAY: Apply new changes from the staging area
-            fs::path staging = fs::current_path() / ".git" / "staging_area";
-            if (fs::exists(staging)) {
-                for (const auto &e : fs::recursive_directory_iterator(staging)) {
-                    if (fs::is_regular_file(e.path())) {
-                        fs::path rel = fs::relative(e.path(), staging);
-                        fs::path dst = dataPath / rel;
-                        fs::create_directories(dst.parent_path());
-
-                        if (fs::exists(dst)) fs::remove(dst);
-                        fs::copy_file(e.path(), dst);
-                    }
+    /**
+     * Collects everything in the staging area as a delta.
+     */
+    static treeDelta stagedChanges() {
+        treeDelta delta;
+        fs::path staging = fs::current_path() / ".git" / "staging_area";
+        memScope phase(PHASE_WALK, "stagedChanges");
+        if (fs::exists(staging)) {
+            for (const auto &e : fs::recursive_directory_iterator(staging)) {
+                if (fs::is_regular_file(e.path())) {
+                    delta.changed.push_back({e.path().lexically_relative(staging).generic_string(), e.path()});
                 }
             }
+        }
+        return delta;
+    }
 
-            // 3. METADATA: Save commit details
-            ofstream info(commitPath / "commitInfo.txt");
-            if (!info.is_open()) throw runtime_error("File Access Error");
-            
-            info << "1." << commitID << "\n";
-            info << "2." << (parentCommitID.empty() ? "NULL" : parentCommitID) << "\n";
-            info << "3." << commitMsg << "\n";
-            info << "4." << get_time() << "\n";
-            info.close();
+    /**
+     * Stores the snapshot through the compiled-in storage backend, then the metadata.
+     * `linkSources` allows delta sources to be hard-linked instead of copied.
+     */
+    void createCommit(const treeDelta& delta, bool linkSources) {
+        try {
+            snapshotBackend store;
+            writeSnapshot(store, commitID, parentCommitID, delta, linkSources);
+            memScope metadata(PHASE_METADATA, "createCommit");
+            writeCommitInfo({commitID, parentCommitID, commitMsg, get_time()});
 
         } catch (const fs::filesystem_error& ex) {
             cerr << RED << "FS Error: " << END << ex.what() << endl;
@@ -159,21 +507,121 @@ public:
     /**
      * Entry point for a new commit. Determines parent and updates HEAD.
      */
-    void addOnTail(string msg) {
-        string parentID;
-        ifstream headIn(".git/HEAD");
-        getline(headIn, parentID);
-        headIn.close();
-
-        parentID = trim(parentID);
-        if (parentID == "NULL") parentID = "";
-
+    void addOnTail(string msg, reflogOp op = OP_COMMIT) {
+        string parentID = readHEAD();
         string newCommitID = gen_random(8);
         commitNode newCommit(newCommitID, parentID, msg);
+        writeHEAD(newCommitID, op);
+    }
+
+    /**
+     * Creates a commit on top of `parentID` from an explicit delta without moving HEAD.
+     * Returns the new commit ID.
+     */
+    string addDelta(const string& parentID, const string& msg, const treeDelta& delta) {
+        string newCommitID = gen_random(8);
+        commitNode newCommit(newCommitID, parentID, msg, delta);
+        return newCommitID;
+    }
+
+    /**
+     * Returns the changes `commitID` made on top of its parent. Only the paths
+     * in its change list are looked up; commits written before change lists
+     * existed diff their manifests by hash, or else both full trees.
+     * `parentStore` and `commitStore` each stay on one commit, so manifests
+     * are read once.
+     */
+    treeDelta commitChanges(const string& commitID, const string& parentID,
+                            snapshotBackend& parentStore, snapshotBackend& commitStore) {
+        treeDelta raw;
+        vector<string> stored, removed;
+        if (readChangeList(commitID, stored, removed)) {
+            for (const auto& p : stored) {
+                if (!commitStore.exists(commitID, p)) continue;
+                fs::path now = commitStore.get(commitID, p);
+                if (parentStore.exists(parentID, p) && storedFilesAreSame(parentStore.get(parentID, p), now)) continue;
+                raw.changed.push_back({p, now});
+            }
+            for (const auto& p : removed) {
+                if (parentStore.exists(parentID, p) && !commitStore.exists(commitID, p)) raw.removed.push_back(p);
+            }
+            return raw;
+        }
+
+        commitManifest before, after;
+        if ((parentID.empty() || readManifest(parentID, before)) && readManifest(commitID, after)) {
+            for (const auto& a : after) {
+                auto b = before.find(a.first);
+                if (b != before.end() && b->second.hash == a.second.hash) continue;
+                raw.changed.push_back({a.first, commitStore.get(commitID, a.first)});
+            }
+            for (const auto& b : before) {
+                if (!after.count(b.first)) raw.removed.push_back(b.first);
+            }
+            return raw;
+        }
+        return diffTrees(parentStore.list(parentID), commitStore.list(commitID));
+    }
+
+    /**
+     * Computes the changes introduced by `commitID` and rebases them onto `onto`.
+     * Paths whose content in `onto` diverged from the commit's parent are reported
+     * as conflicts. Changes already present in `onto` are dropped from the delta.
+     * Only the changed paths of the commit and its parent are read.
+     */
+    bool planReplay(const string& commitID, const commitTree& onto,
+                    treeDelta& delta, vector<string>& conflicts) {
+        commitInfo info;
+        if (!readCommitInfo(commitID, info)) return false;
+
+        snapshotBackend parentStore, commitStore;
+        treeDelta raw = commitChanges(commitID, info.parent, parentStore, commitStore);
+        delta = treeDelta();
+
+        for (const auto &c : raw.changed) {
+            auto have = onto.find(c.first);
+            if (have != onto.end() && storedFilesAreSame(have->second, c.second)) continue;
+
+            bool baseMatches = !parentStore.exists(info.parent, c.first) ? (have == onto.end())
+                             : (have != onto.end() && storedFilesAreSame(have->second, parentStore.get(info.parent, c.first)));
+            if (!baseMatches) conflicts.push_back(c.first);
+            else delta.changed.push_back(c);
+        }
+        for (const auto &r : raw.removed) {
+            auto have = onto.find(r);
+            if (have == onto.end()) continue;
+            if (!storedFilesAreSame(have->second, parentStore.get(info.parent, r))) conflicts.push_back(r);
+            else delta.removed.push_back(r);
+        }
+        return conflicts.empty();
+    }
+
+    /**
+     * Collects the commits reachable from `tipID` that are not reachable from
+     * `baseID`, oldest first.
+     */
+    vector<string> commitsSince(const string& tipID, const string& baseID) {
+        set<string> excluded;
+        commitInfo info;
+        for (string id = baseID; readCommitInfo(id, info); id = info.parent) excluded.insert(id);
+
+        vector<string> chain;
+        for (string id = tipID; !excluded.count(id) && readCommitInfo(id, info); id = info.parent) {
+            chain.push_back(id);
+        }
+        reverse(chain.begin(), chain.end());
+        return chain;
+    }
 
-        ofstream headOut(".git/HEAD", ios::trunc);
-        headOut << newCommitID;
-        headOut.close();
+    /**
+     * Lists the commit IDs reachable from HEAD, newest first.
+     */
+    vector<string> history() {
+        vector<string> ids;
+        commitInfo info;
+        metadata().willNeedAll();
+        for (string id = readHEAD(); readCommitInfo(id, info); id = info.parent) ids.push_back(id);
+        return ids;
     }
 
     /**
@@ -184,67 +632,40 @@ public:
 
         // Resolve "HEAD" to actual hash
         if (commitHash == "HEAD") {
-            ifstream headFile(".git/HEAD");
-            if (!headFile.is_open()) return false;
-            getline(headFile, targetHash);
-            headFile.close();
-            targetHash = trim(targetHash);
-
-            if (targetHash == "NULL" || targetHash.empty()) {
+            targetHash = readHEAD();
+            if (targetHash.empty()) {
                 cout << RED << "Error: No commits exist yet." << END << endl;
                 return false;
             }
         }
 
-        fs::path commitInfoPath = fs::current_path() / ".git" / "commits" / targetHash / "commitInfo.txt";
-        if (!fs::exists(commitInfoPath)) {
+        // Read message from target commit to reuse it
+        commitInfo info;
+        if (!readCommitInfo(targetHash, info)) {
             cout << RED << "Invalid commit hash: " << targetHash << END << endl;
             return false;
         }
 
-        // Read message from target commit to reuse it
-        string line, msg;
-        ifstream file(commitInfoPath);
-        while (getline(file, line)) {
-            if (line[0] == '3') msg = line.substr(2);
-        }
-        file.close();
-
-        addOnTail(msg + " (Revert of " + targetHash + ")");
+        addOnTail(info.msg + " (Revert of " + targetHash + ")", OP_REVERT);
         return true;
     }
 
     /**
      * Walks backward through history using Parent IDs.
+     * `afterEach` (if set) is called with each commit ID after its header is printed.
      */
-    void printCommitList() {
-        ifstream headIn(".git/HEAD");
-        string currID;
-        getline(headIn, currID);
-        headIn.close();
-
-        currID = trim(currID);
-
-        while (!currID.empty() && currID != "NULL") {
-            fs::path infoPath = fs::current_path() / ".git" / "commits" / currID / "commitInfo.txt";
-            if (!fs::exists(infoPath)) break;
-
-            ifstream file(infoPath);
-            string line, parentID = "";
-
-            while (getline(file, line)) {
-                if (line.empty()) continue;
-                switch (line[0]) {
-                    case '1': cout << "Commit ID:    " << line.substr(2) << endl; break;
-                    case '3': cout << "Commit Msg:   " << line.substr(2) << endl; break;
-                    case '4': cout << "Date & Time:  " << line.substr(2) << endl; break;
-                    case '2': parentID = line.substr(2); break;
-                }
-            }
-            file.close();
+    void printCommitList(function<void(const string&)> afterEach = nullptr) {
+        memScope phase(PHASE_METADATA, "printCommitList");
+        commitInfo info;
+        metadata().willNeedAll();
+
+        for (string currID = readHEAD(); readCommitInfo(currID, info); currID = info.parent) {
+            cout << "Commit ID:    " << info.id << '\n';
+            cout << "Commit Msg:   " << info.msg << '\n';
+            cout << "Date & Time:  " << info.time << '\n';
 
+            if (afterEach) afterEach(currID);
             cout << "============================\n\n";
-            currID = trim(parentID);
         }
     }
 };
\ No newline at end of file
@@ -0,0 +1,239 @@
+/**
+ * CRC32C.CPP
+ * Purpose: Cheap corruption detection for metadata. A CRC32C (Castagnoli)
+ * trailer is appended to HEAD, commit metadata, manifests and segment indexes
+ * and checked on every read. The checksum runs on the SSE4.2 / ARMv8 CRC
+ * instructions where available, with a slicing-by-8 table fallback.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "config.cpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MYGIT_CRC32C_SSE42
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define MYGIT_CRC32C_ARM
+#include <arm_acle.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// CRC32C
+// =============================================================================
+
+const uint32_t CRC32C_POLY = 0x82F63B78;    // Castagnoli, bit-reversed
+
+struct crc32cTables {
+    uint32_t t[8][256];
+
+    crc32cTables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c >> 1) ^ ((c & 1) ? CRC32C_POLY : 0);
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int s = 1; s < 8; s++) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+        }
+    }
+};
+
+/**
+ * Slicing-by-8: eight table lookups per 8 input bytes. `crc` is the raw
+ * (non-inverted) register value.
+ */
+uint32_t crc32cSoftware(uint32_t crc, const uint8_t* p, size_t n) {
+    static const crc32cTables tables;
+    const auto& t = tables.t;
+    while (n >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while (n--) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(MYGIT_CRC32C_SSE42)
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware(uint32_t crc, const uint8_t* p, size_t n) {
+#if defined(__x86_64__)
+    uint64_t c = crc;
+    while (n >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+        p += 8;
+        n -= 8;
+    }
+    crc = (uint32_t)c;
+#endif
+    while (n--) crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+
+bool crc32cHardwareAvailable() {
+    static const bool available = __builtin_cpu_supports("sse4.2");
+    return available;
+}
+#elif defined(MYGIT_CRC32C_ARM)
+uint32_t crc32cHardware(uint32_t crc, const uint8_t* p, size_t n) {
+    while (n >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        crc = __crc32cd(crc, v);
+        p += 8;
+        n -= 8;
+    }
+    while (n--) crc = __crc32cb(crc, *p++);
+    return crc;
+}
+
+bool crc32cHardwareAvailable() { return true; }
+#else
+uint32_t crc32cHardware(uint32_t crc, const uint8_t* p, size_t n) { return crc32cSoftware(crc, p, n); }
+bool crc32cHardwareAvailable() { return false; }
+#endif
+
+/**
+ * CRC32C of `n` bytes. Pass a previous result as `crc` to continue a running checksum.
+ */
+uint32_t crc32c(const void* data, size_t n, uint32_t crc = 0) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    crc = crc32cHardwareAvailable() ? crc32cHardware(crc, p, n) : crc32cSoftware(crc, p, n);
+    return ~crc;
+}
+
+// =============================================================================
+// CHECKSUMMED FILES
+// Text files end with a "#crc32c xxxxxxxx" line covering everything before it;
+// line-based readers skip it since no field starts with '#'. Binary files end
+// with the little-endian u32 CRC of everything before it.
+// Files written before checksums existed have no trailer and are accepted,
+// unless "core.checksums = required" (set by init for new repositories).
+// =============================================================================
+
+const char CRC_TRAILER_TAG[] = "#crc32c ";
+const size_t CRC_TRAILER_LEN = 17;          // Tag + 8 hex digits + '\n'
+
+bool checksumsRequired() {
+    static const bool required = configValue("core.checksums", "optional") == "required";
+    return required;
+}
+
+/**
+ * Corrupt metadata is never parsed: report the file and stop.
+ */
+[[noreturn]] void checksumFailure(const fs::path& p) {
+    cerr << "\x1B[31m" << "Error: " << "\033[0m" << p.generic_string()
+         << " is corrupt (checksum mismatch or truncated)." << endl;
+    exit(1);
+}
+
+/**
+ * Returns `body` (newline-terminated) followed by its checksum line.
+ */
+string sealText(string body) {
+    if (!body.empty() && body.back() != '\n') body += '\n';
+    char trailer[CRC_TRAILER_LEN + 1];
+    snprintf(trailer, sizeof(trailer), "%s%08x\n", CRC_TRAILER_TAG, crc32c(body.data(), body.size()));
+    return body + trailer;
+}
+
+/**
+ * Flushes a file's content, or a directory's entries, to stable storage.
+ */
+bool syncPath(const fs::path& p) {
+#ifndef _WIN32
+    int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#else
+    return true;
+#endif
+}
+
+/**
+ * Writes a checksummed text file under a temporary name and renames it into
+ * place, so readers see either the old or the new content. With `durable`,
+ * the content and the rename reach the disk before this returns.
+ */
+bool writeSealedText(const fs::path& p, const string& body, bool durable = false) {
+    fs::path tmp = p;
+    tmp += ".tmp";
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out.is_open()) return false;
+        string sealed = sealText(body);
+        out.write(sealed.data(), (streamsize)sealed.size());
+        if (!out) return false;
+    }
+    if (durable && !syncPath(tmp)) return false;
+    error_code ec;
+    fs::rename(tmp, p, ec);
+    if (ec) return false;
+    return !durable || syncPath(p.parent_path().empty() ? fs::path(".") : p.parent_path());
+}
+
+/**
+ * Reads a text file and strips its checksum line. Returns false if the file
+ * cannot be opened; exits if the checksum does not match.
+ */
+bool readSealedText(const fs::path& p, string& body) {
+    ifstream in(p, ios::binary);
+    if (!in.is_open()) return false;
+    body.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+
+    size_t start = body.size() >= CRC_TRAILER_LEN ? body.size() - CRC_TRAILER_LEN : string::npos;
+    if (start == string::npos || body.compare(start, 8, CRC_TRAILER_TAG) != 0 || body.back() != '\n') {
+        if (checksumsRequired()) checksumFailure(p);
+        return true;
+    }
+
+    uint32_t stored = (uint32_t)strtoul(body.substr(start + 8, 8).c_str(), nullptr, 16);
+    body.resize(start);
+    if (crc32c(body.data(), body.size()) != stored) checksumFailure(p);
+    return true;
+}
+
+/**
+ * Checks the binary trailer of a loaded file of fixed-size records.
+ * `data` holds the whole file; `recordSize` tells a legacy file (a whole
+ * number of records) from one carrying a 4-byte trailer. Returns the payload
+ * length (without the trailer); exits on mismatch.
+ */
+size_t verifyRecordTrailer(const fs::path& p, const char* data, size_t size, size_t recordSize) {
+    if (size % recordSize != sizeof(uint32_t)) {
+        if (size % recordSize != 0 || checksumsRequired()) checksumFailure(p);
+        return size;
+    }
+    size_t payload = size - sizeof(uint32_t);
+    uint32_t stored;
+    memcpy(&stored, data + payload, sizeof(stored));
+    if (crc32c(data, payload) != stored) checksumFailure(p);
+    return payload;
+}
@@ -0,0 +1,242 @@
+/**
+ * DIFFSTAT.CPP
+ * Purpose: Per-commit "files changed / lines added / lines removed" summaries
+ * for `log --stat`. Stats are computed in parallel across commits and cached
+ * in .git/cache/stat/<commitID>, which is valid forever since commits are immutable.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// LINE DIFF
+// =============================================================================
+
+// Edit distance and line comparisons the Myers search may spend on one file;
+// past either limit the file is counted as fully rewritten
+const long DIFF_MAX_EDITS = 4096;
+const long DIFF_MAX_WORK = 1L << 26;
+
+struct fileStat {
+    string path;
+    long added = 0;
+    long removed = 0;
+    bool binary = false;
+};
+
+/**
+ * Loads a stored file as text. Returns false for binary content
+ * (a NUL byte near the start, or a large-file pointer).
+ */
+bool loadText(const fs::path& p, string& text) {
+    largePointer ptr;
+    if (readLargePointer(p, ptr)) return false;
+
+    ifstream in(p, ios::binary);
+    text.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    return text.find('\0') >= 8000;
+}
+
+vector<string_view> splitLines(const string& text) {
+    vector<string_view> lines;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t nl = text.find('\n', start);
+        if (nl == string::npos) nl = text.size();
+        lines.emplace_back(text.data() + start, nl - start);
+        start = nl + 1;
+    }
+    return lines;
+}
+
+/**
+ * Counts inserted and deleted lines between two texts using Myers' O((N+M)D)
+ * shortest-edit-script search. Only the edit distance is needed, so no path is kept.
+ * Huge or heavily rewritten files stop at DIFF_MAX_EDITS / DIFF_MAX_WORK and
+ * report every differing line as removed and added.
+ */
+void countLineChanges(const string& oldText, const string& newText, long& added, long& removed) {
+    vector<string_view> a = splitLines(oldText), b = splitLines(newText);
+
+    // Intern lines so the search compares integers
+    unordered_map<string_view, int> ids;
+    vector<int> x, y;
+    for (auto l : a) x.push_back(ids.emplace(l, (int)ids.size()).first->second);
+    for (auto l : b) y.push_back(ids.emplace(l, (int)ids.size()).first->second);
+
+    // Common prefix and suffix never contribute to the edit script
+    size_t lo = 0;
+    while (lo < x.size() && lo < y.size() && x[lo] == y[lo]) lo++;
+    size_t hiX = x.size(), hiY = y.size();
+    while (hiX > lo && hiY > lo && x[hiX - 1] == y[hiY - 1]) { hiX--; hiY--; }
+
+    long n = (long)(hiX - lo), m = (long)(hiY - lo);
+    long max = min(n + m, DIFF_MAX_EDITS), d = n + m;
+    vector<long> v(2 * max + 2, 0);
+    long offset = max, work = 0;
+
+    for (long step = 0; step <= max && work < DIFF_MAX_WORK; step++) {
+        bool done = false;
+        for (long k = -step; k <= step; k += 2) {
+            long px = (k == -step || (k != step && v[offset + k - 1] < v[offset + k + 1]))
+                    ? v[offset + k + 1] : v[offset + k - 1] + 1;
+            long py = px - k, from = px;
+            while (px < n && py < m && x[lo + px] == y[lo + py]) { px++; py++; }
+            work += px - from + 1;
+            v[offset + k] = px;
+            if (px >= n && py >= m) { done = true; break; }
+        }
+        if (done) { d = step; break; }
+    }
+
+    added = (d + (m - n)) / 2;
+    removed = (d - (m - n)) / 2;
+}
+
+// =============================================================================
+// PER-COMMIT STATS
+// =============================================================================
+
+/**
+ * Diffs a commit against its parent.
+ */
+vector<fileStat> computeCommitStat(const string& commitID) {
+    commitInfo info;
+    readCommitInfo(commitID, info);
+    commitTree before = readTree(info.parent);
+    commitTree after = readTree(commitID);
+    treeDelta delta = diffTrees(before, after);
+
+    vector<fileStat> stats;
+    string oldText, newText;
+    for (const auto& c : delta.changed) {
+        fileStat st;
+        st.path = c.first;
+        auto was = before.find(c.first);
+        bool textOld = (was == before.end()) ? (oldText.clear(), true) : loadText(was->second, oldText);
+        bool textNew = loadText(c.second, newText);
+        if (!textOld || !textNew) st.binary = true;
+        else countLineChanges(oldText, newText, st.added, st.removed);
+        stats.push_back(st);
+    }
+    for (const auto& r : delta.removed) {
+        fileStat st;
+        st.path = r;
+        if (loadText(before.at(r), oldText)) st.removed = (long)splitLines(oldText).size();
+        else st.binary = true;
+        stats.push_back(st);
+    }
+    sort(stats.begin(), stats.end(), [](const fileStat& l, const fileStat& r) { return l.path < r.path; });
+    return stats;
+}
+
+fs::path statCachePath(const string& commitID) {
+    return fs::path(".git") / "cache" / "stat" / commitID;
+}
+
+/**
+ * Parses a cached line count. A damaged cache entry is a miss, not an error.
+ */
+bool parseCount(const string& text, long& count) {
+    char* end = nullptr;
+    errno = 0;
+    count = strtol(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && errno == 0 && count >= 0;
+}
+
+bool loadCachedStat(const string& commitID, vector<fileStat>& stats) {
+    ifstream in(statCachePath(commitID));
+    if (!in.is_open()) return false;
+
+    string line;
+    while (getline(in, line)) {
+        istringstream row(line);
+        string added, removed;
+        fileStat st;
+        if (!getline(row, added, '\t') || !getline(row, removed, '\t') || !getline(row, st.path)) return false;
+        st.binary = (added == "-");
+        if (!st.binary && (!parseCount(added, st.added) || !parseCount(removed, st.removed))) return false;
+        stats.push_back(st);
+    }
+    return true;
+}
+
+void saveCachedStat(const string& commitID, const vector<fileStat>& stats) {
+    fs::path target = statCachePath(commitID);
+    error_code ec;
+    fs::create_directories(target.parent_path(), ec);
+
+    // Workers of concurrent log --stat runs may save the same commit; each writes its own tmp file
+    fs::path tmp = target;
+    tmp += "." + to_string(getpid()) + "-" + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    bool written;
+    {
+        ofstream out(tmp, ios::trunc);
+        for (const auto& st : stats) {
+            if (st.binary) out << "-\t-\t" << st.path << "\n";
+            else out << st.added << "\t" << st.removed << "\t" << st.path << "\n";
+        }
+        written = bool(out);
+    }
+
+    // The cache is only an optimization, and this runs on worker threads where a throw would terminate
+    if (written) fs::rename(tmp, target, ec);
+    if (!written || ec) fs::remove(tmp, ec);
+}
+
+/**
+ * Returns the stats for each commit, reading the cache where possible and
+ * computing the misses on worker threads.
+ */
+vector<vector<fileStat>> commitStats(const vector<string>& ids) {
+    vector<vector<fileStat>> stats(ids.size());
+    vector<size_t> misses;
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (!loadCachedStat(ids[i], stats[i])) {
+            stats[i].clear();
+            misses.push_back(i);
+        }
+    }
+
+    atomic<size_t> next(0);
+    vector<thread> workers;
+    for (unsigned t = 0; t < min<size_t>(workerThreads(), misses.size()); t++) {
+        workers.emplace_back([&]() {
+            for (size_t m = next++; m < misses.size(); m = next++) {
+                size_t i = misses[m];
+                stats[i] = computeCommitStat(ids[i]);
+                saveCachedStat(ids[i], stats[i]);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    return stats;
+}
+
+void printCommitStat(const vector<fileStat>& stats) {
+    long added = 0, removed = 0;
+    for (const auto& st : stats) {
+        cout << " " << st.path << " | ";
+        if (st.binary) cout << "Bin" << "\n";
+        else cout << "+" << st.added << " -" << st.removed << "\n";
+        added += st.added;
+        removed += st.removed;
+    }
+    cout << " " << stats.size() << " file(s) changed, " << added << " insertion(s)(+), "
+         << removed << " deletion(s)(-)\n";
+}
@@ -0,0 +1,151 @@
+/**
+ * EXTSORT.CPP
+ * Purpose: Memory-bounded sorted collection of path strings. Once the buffered
+ * paths exceed the byte budget they are sorted and spilled to a run file on
+ * disk; iteration k-way merges the runs so output stays sorted.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// EXTERNAL SORTER CLASS
+// =============================================================================
+
+class externalSorter {
+private:
+    string name;
+    uint64_t budget;            // 0 = unlimited (never spills)
+    uint64_t buffered = 0;
+    uint64_t total = 0;
+    vector<string> buffer;
+    vector<fs::path> runs;
+
+    uint64_t spills = 0;
+
+    // Rough per-entry cost of a std::string held in a vector
+    static const uint64_t ENTRY_OVERHEAD = sizeof(string) + 16;
+    // Runs are merged down before this many would be open at once
+    static const size_t MAX_RUNS = 64;
+
+    fs::path nextRunPath() {
+        fs::path dir = fs::path(".git") / "tmp";
+        fs::create_directories(dir);
+        return dir / (name + "-" + to_string(getpid()) + "-" + to_string(spills++) + ".run");
+    }
+
+    // Run records are length-prefixed, so entries may hold any byte (a path can contain '\n')
+    static void writeRecord(ofstream& out, const string& s) {
+        uint32_t n = (uint32_t)s.size();
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        out.write(s.data(), (streamsize)n);
+    }
+
+    static bool readRecord(ifstream& in, string& s) {
+        uint32_t n;
+        if (!in.read(reinterpret_cast<char*>(&n), sizeof(n))) return false;
+        s.resize(n);
+        return bool(in.read(&s[0], (streamsize)n));
+    }
+
+    /**
+     * K-way merges the run files (and, if `withBuffer`, the sorted buffer) in order.
+     */
+    void merge(const vector<fs::path>& sources, bool withBuffer, const function<void(const string&)>& visit) {
+        vector<ifstream> files;
+        for (const auto& r : sources) files.emplace_back(r, ios::binary);
+
+        typedef pair<string, size_t> head;     // (value, source); source == files.size() is the buffer
+        priority_queue<head, vector<head>, greater<head>> heap;
+        size_t bufPos = 0;
+
+        auto pull = [&](size_t src) {
+            string record;
+            if (src == files.size()) {
+                if (withBuffer && bufPos < buffer.size()) heap.push({buffer[bufPos++], src});
+            } else if (readRecord(files[src], record)) {
+                heap.push({record, src});
+            }
+        };
+
+        for (size_t i = 0; i <= files.size(); i++) pull(i);
+        while (!heap.empty()) {
+            head top = heap.top();
+            heap.pop();
+            visit(top.first);
+            pull(top.second);
+        }
+    }
+
+    void spill() {
+        sort(buffer.begin(), buffer.end());
+
+        fs::path run = nextRunPath();
+        {
+            ofstream out(run, ios::binary | ios::trunc);
+            for (const auto& s : buffer) writeRecord(out, s);
+            if (!out) throw runtime_error("File Access Error");
+        }
+        runs.push_back(run);
+
+        // Release the memory, not just the elements
+        vector<string>().swap(buffer);
+        buffered = 0;
+
+        // Keep the number of simultaneously open runs bounded
+        if (runs.size() >= MAX_RUNS) {
+            fs::path merged = nextRunPath();
+            {
+                ofstream out(merged, ios::binary | ios::trunc);
+                merge(runs, false, [&](const string& s) { writeRecord(out, s); });
+                if (!out) throw runtime_error("File Access Error");
+            }
+            for (const auto& r : runs) fs::remove(r);
+            runs.assign(1, merged);
+        }
+    }
+
+public:
+    externalSorter(string runName, uint64_t byteBudget) : name(runName), budget(byteBudget) {}
+
+    ~externalSorter() {
+        for (const auto& r : runs) fs::remove(r);
+    }
+
+    void add(const string& s) {
+        buffer.push_back(s);
+        buffered += s.size() + ENTRY_OVERHEAD;
+        total++;
+        if (budget && buffered >= budget) spill();
+    }
+
+    uint64_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    /**
+     * Visits every entry in sorted order.
+     */
+    void forEach(const function<void(const string&)>& visit) {
+        sort(buffer.begin(), buffer.end());
+        if (runs.empty()) {
+            for (const auto& s : buffer) visit(s);
+            return;
+        }
+
+        // The in-memory tail acts as one more run
+        merge(runs, true, visit);
+    }
+};
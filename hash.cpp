@@ -0,0 +1,376 @@
+/**
+ * HASH.CPP
+ * Purpose: Content fingerprinting. A portable BLAKE3 implementation used to
+ * name stored objects and to compare working-tree files against them.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "config.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// BLAKE3 PRIMITIVES
+// =============================================================================
+
+const size_t BLAKE3_BLOCK_LEN = 64;
+const size_t BLAKE3_CHUNK_LEN = 1024;
+
+const uint32_t BLAKE3_IV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+const uint8_t BLAKE3_MSG_PERMUTATION[16] = {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+
+enum blake3Flag : uint32_t {
+    CHUNK_START = 1 << 0,
+    CHUNK_END   = 1 << 1,
+    PARENT      = 1 << 2,
+    ROOT        = 1 << 3,
+};
+
+inline uint32_t rotr32(uint32_t w, uint32_t c) { return (w >> c) | (w << (32 - c)); }
+
+inline void blake3G(uint32_t s[16], int a, int b, int c, int d, uint32_t mx, uint32_t my) {
+    s[a] = s[a] + s[b] + mx; s[d] = rotr32(s[d] ^ s[a], 16);
+    s[c] = s[c] + s[d];      s[b] = rotr32(s[b] ^ s[c], 12);
+    s[a] = s[a] + s[b] + my; s[d] = rotr32(s[d] ^ s[a], 8);
+    s[c] = s[c] + s[d];      s[b] = rotr32(s[b] ^ s[c], 7);
+}
+
+/**
+ * The BLAKE3 compression function. Writes the full 16-word output state.
+ */
+void blake3Compress(const uint32_t cv[8], const uint32_t block[16], uint64_t counter,
+                    uint32_t blockLen, uint32_t flags, uint32_t out[16]) {
+    uint32_t s[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        BLAKE3_IV[0], BLAKE3_IV[1], BLAKE3_IV[2], BLAKE3_IV[3],
+        (uint32_t)counter, (uint32_t)(counter >> 32), blockLen, flags
+    };
+    uint32_t m[16], tmp[16];
+    memcpy(m, block, sizeof(m));
+
+    for (int round = 0; round < 7; round++) {
+        blake3G(s, 0, 4, 8, 12, m[0], m[1]);
+        blake3G(s, 1, 5, 9, 13, m[2], m[3]);
+        blake3G(s, 2, 6, 10, 14, m[4], m[5]);
+        blake3G(s, 3, 7, 11, 15, m[6], m[7]);
+        blake3G(s, 0, 5, 10, 15, m[8], m[9]);
+        blake3G(s, 1, 6, 11, 12, m[10], m[11]);
+        blake3G(s, 2, 7, 8, 13, m[12], m[13]);
+        blake3G(s, 3, 4, 9, 14, m[14], m[15]);
+
+        for (int i = 0; i < 16; i++) tmp[i] = m[BLAKE3_MSG_PERMUTATION[i]];
+        memcpy(m, tmp, sizeof(m));
+    }
+
+    for (int i = 0; i < 8; i++) {
+        out[i] = s[i] ^ s[i + 8];
+        out[i + 8] = s[i + 8] ^ cv[i];
+    }
+}
+
+inline void blake3Words(const uint8_t* bytes, uint32_t words[16]) {
+    for (int i = 0; i < 16; i++) {
+        words[i] = (uint32_t)bytes[4 * i] | ((uint32_t)bytes[4 * i + 1] << 8) |
+                   ((uint32_t)bytes[4 * i + 2] << 16) | ((uint32_t)bytes[4 * i + 3] << 24);
+    }
+}
+
+/**
+ * A node that has been fully absorbed but not yet compressed, so the caller
+ * can decide whether it is the root.
+ */
+struct blake3Output {
+    uint32_t cv[8];
+    uint32_t block[16];
+    uint64_t counter;
+    uint32_t blockLen;
+    uint32_t flags;
+
+    void chainingValue(uint32_t out[8]) const {
+        uint32_t full[16];
+        blake3Compress(cv, block, counter, blockLen, flags, full);
+        memcpy(out, full, 8 * sizeof(uint32_t));
+    }
+
+    void rootBytes(uint8_t out[32]) const {
+        uint32_t full[16];
+        blake3Compress(cv, block, 0, blockLen, flags | ROOT, full);
+        for (int i = 0; i < 8; i++) {
+            for (int b = 0; b < 4; b++) out[4 * i + b] = (uint8_t)(full[i] >> (8 * b));
+        }
+    }
+};
+
+blake3Output blake3Parent(const uint32_t left[8], const uint32_t right[8]) {
+    blake3Output o;
+    memcpy(o.cv, BLAKE3_IV, sizeof(o.cv));
+    memcpy(o.block, left, 8 * sizeof(uint32_t));
+    memcpy(o.block + 8, right, 8 * sizeof(uint32_t));
+    o.counter = 0;
+    o.blockLen = BLAKE3_BLOCK_LEN;
+    o.flags = PARENT;
+    return o;
+}
+
+/**
+ * Absorbs up to one 1 KiB chunk.
+ */
+struct blake3Chunk {
+    uint32_t cv[8];
+    uint64_t counter;
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    size_t blockLen = 0;
+    size_t blocksCompressed = 0;
+
+    explicit blake3Chunk(uint64_t chunkCounter) : counter(chunkCounter) {
+        memcpy(cv, BLAKE3_IV, sizeof(cv));
+        memset(block, 0, sizeof(block));
+    }
+
+    size_t len() const { return blocksCompressed * BLAKE3_BLOCK_LEN + blockLen; }
+    uint32_t startFlag() const { return blocksCompressed == 0 ? (uint32_t)CHUNK_START : 0; }
+
+    void update(const uint8_t* in, size_t n) {
+        while (n > 0) {
+            if (blockLen == BLAKE3_BLOCK_LEN) {
+                uint32_t words[16], full[16];
+                blake3Words(block, words);
+                blake3Compress(cv, words, counter, BLAKE3_BLOCK_LEN, startFlag(), full);
+                memcpy(cv, full, sizeof(cv));
+                blocksCompressed++;
+                blockLen = 0;
+                memset(block, 0, sizeof(block));
+            }
+            size_t take = min(BLAKE3_BLOCK_LEN - blockLen, n);
+            memcpy(block + blockLen, in, take);
+            blockLen += take;
+            in += take;
+            n -= take;
+        }
+    }
+
+    blake3Output output() const {
+        blake3Output o;
+        memcpy(o.cv, cv, sizeof(cv));
+        blake3Words(block, o.block);
+        o.counter = counter;
+        o.blockLen = (uint32_t)blockLen;
+        o.flags = startFlag() | CHUNK_END;
+        return o;
+    }
+};
+
+// =============================================================================
+// INCREMENTAL HASHER
+// =============================================================================
+
+class blake3Hasher {
+private:
+    blake3Chunk chunk{0};
+    uint32_t stack[54][8];
+    size_t stackLen = 0;
+
+    void pushChunkCV(uint32_t cv[8], uint64_t totalChunks) {
+        // Each trailing zero bit of the chunk count completes one subtree
+        while ((totalChunks & 1) == 0) {
+            blake3Parent(stack[--stackLen], cv).chainingValue(cv);
+            totalChunks >>= 1;
+        }
+        memcpy(stack[stackLen++], cv, 8 * sizeof(uint32_t));
+    }
+
+public:
+    /**
+     * Absorbs the chaining value of a complete subtree covering chunks
+     * [first, first + count). `count` must be a power of two, `first` a multiple
+     * of it, and the hasher must be positioned exactly at `first`.
+     */
+    void absorbSubtree(const uint32_t subtreeCV[8], uint64_t first, uint64_t count) {
+        uint32_t cv[8];
+        memcpy(cv, subtreeCV, sizeof(cv));
+
+        uint64_t total = (first + count) / count;
+        while ((total & 1) == 0) {
+            blake3Parent(stack[--stackLen], cv).chainingValue(cv);
+            total >>= 1;
+        }
+        memcpy(stack[stackLen++], cv, sizeof(cv));
+        chunk = blake3Chunk(first + count);
+    }
+
+    void update(const void* data, size_t n) {
+        const uint8_t* in = static_cast<const uint8_t*>(data);
+        while (n > 0) {
+            if (chunk.len() == BLAKE3_CHUNK_LEN) {
+                uint32_t cv[8];
+                chunk.output().chainingValue(cv);
+                uint64_t total = chunk.counter + 1;
+                pushChunkCV(cv, total);
+                chunk = blake3Chunk(total);
+            }
+            size_t take = min(BLAKE3_CHUNK_LEN - chunk.len(), n);
+            chunk.update(in, take);
+            in += take;
+            n -= take;
+        }
+    }
+
+    /**
+     * Returns the 32-byte digest as lowercase hex.
+     */
+    string hexDigest() const {
+        blake3Output out = chunk.output();
+        for (size_t i = stackLen; i > 0; i--) {
+            uint32_t cv[8];
+            out.chainingValue(cv);
+            out = blake3Parent(stack[i - 1], cv);
+        }
+
+        uint8_t bytes[32];
+        out.rootBytes(bytes);
+        static const char hex[] = "0123456789abcdef";
+        string s;
+        for (uint8_t b : bytes) {
+            s += hex[b >> 4];
+            s += hex[b & 15];
+        }
+        return s;
+    }
+};
+
+// =============================================================================
+// HELPERS
+// =============================================================================
+
+const size_t HASH_BUFFER = 1 << 20;
+const uint64_t HASH_MIN_PIECE_CHUNKS = 256;
+const uint64_t HASH_DEFAULT_PARALLEL_THRESHOLD = 32ull << 20;
+
+/**
+ * Computes the chaining value of the complete subtree covering chunks
+ * [first, first + count) of a file, reading it in constant memory. Returns
+ * false if the file no longer holds those chunks.
+ */
+bool blake3SubtreeCV(const fs::path& p, uint64_t first, uint64_t count, uint32_t out[8]) {
+    ifstream in(p, ios::binary);
+    in.seekg(first * BLAKE3_CHUNK_LEN);
+
+    vector<char> buf(HASH_BUFFER);
+    uint32_t stack[54][8];
+    size_t stackLen = 0;
+    uint64_t done = 0;
+
+    while (done < count) {
+        uint64_t want = min<uint64_t>(buf.size() / BLAKE3_CHUNK_LEN, count - done);
+        if (!in.read(buf.data(), want * BLAKE3_CHUNK_LEN)) return false;
+
+        for (uint64_t i = 0; i < want; i++, done++) {
+            blake3Chunk c(first + done);
+            c.update(reinterpret_cast<const uint8_t*>(buf.data()) + i * BLAKE3_CHUNK_LEN, BLAKE3_CHUNK_LEN);
+            uint32_t cv[8];
+            c.output().chainingValue(cv);
+
+            for (uint64_t total = done + 1; (total & 1) == 0; total >>= 1) {
+                blake3Parent(stack[--stackLen], cv).chainingValue(cv);
+            }
+            memcpy(stack[stackLen++], cv, sizeof(cv));
+        }
+    }
+    memcpy(out, stack[0], 8 * sizeof(uint32_t));
+    return true;
+}
+
+/**
+ * Hashes a large file by splitting every chunk but the last into aligned
+ * power-of-two subtrees, hashing those on worker threads, and folding their
+ * chaining values back in order. Produces the same digest as a serial pass.
+ * Needs at least two chunks.
+ */
+string hashFileParallel(const fs::path& p, uintmax_t size, unsigned threads) {
+    uint64_t totalChunks = (size + BLAKE3_CHUNK_LEN - 1) / BLAKE3_CHUNK_LEN;
+    uint64_t subtreeChunks = totalChunks - 1;   // The last chunk may hold the root
+
+    uint64_t cap = HASH_MIN_PIECE_CHUNKS;
+    while (cap * 2 <= subtreeChunks / (threads * 4)) cap *= 2;
+
+    struct piece { uint64_t first, count; uint32_t cv[8]; bool ok; };
+    vector<piece> pieces;
+    for (uint64_t c = 0; c < subtreeChunks;) {
+        uint64_t n = cap;
+        while (c % n != 0 || c + n > subtreeChunks) n /= 2;
+        pieces.push_back({c, n, {}, false});
+        c += n;
+    }
+
+    atomic<size_t> next(0);
+    vector<thread> workers;
+    for (unsigned t = 0; t < min<size_t>(threads, pieces.size()); t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < pieces.size(); i = next++) {
+                pieces[i].ok = blake3SubtreeCV(p, pieces[i].first, pieces[i].count, pieces[i].cv);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    // A short read means the file shrank while it was hashed
+    for (const auto& pc : pieces) {
+        if (!pc.ok) throw runtime_error("File Access Error");
+    }
+
+    blake3Hasher h;
+    for (const auto& pc : pieces) h.absorbSubtree(pc.cv, pc.first, pc.count);
+
+    ifstream in(p, ios::binary);
+    in.seekg(subtreeChunks * BLAKE3_CHUNK_LEN);
+    char tail[BLAKE3_CHUNK_LEN];
+    in.read(tail, sizeof(tail));
+    h.update(tail, in.gcount());
+    return h.hexDigest();
+}
+
+/**
+ * Threshold above which file hashing is spread across worker threads
+ * ("hash.parallelThreshold").
+ */
+uint64_t parallelHashThreshold() {
+    static uint64_t threshold = configSize("hash.parallelThreshold", HASH_DEFAULT_PARALLEL_THRESHOLD);
+    return threshold;
+}
+
+/**
+ * Hashes a file's content in constant memory (per thread).
+ */
+string hashFile(const fs::path& p) {
+    error_code ec;
+    uintmax_t size = fs::file_size(p, ec);
+    if (!ec && size > BLAKE3_CHUNK_LEN && size >= parallelHashThreshold() && workerThreads() > 1) {
+        return hashFileParallel(p, size, workerThreads());
+    }
+
+    ifstream in(p, ios::binary);
+    vector<char> buf(HASH_BUFFER);
+    blake3Hasher h;
+    while (in.read(buf.data(), buf.size()) || in.gcount() > 0) h.update(buf.data(), in.gcount());
+    return h.hexDigest();
+}
+
+string hashString(const string& s) {
+    blake3Hasher h;
+    h.update(s.data(), s.size());
+    return h.hexDigest();
+}
@@ -0,0 +1,322 @@
+/**
+ * INSTRUMENT.CPP
+ * Purpose: Optional runtime instrumentation surfaced by CLI flags.
+ * --mem-stats : peak RSS, plus allocation counts/bytes per phase and per site
+ *               when built with -DMYGIT_MEM_STATS (replaces global operator new).
+ * --latency   : log-bucketed latency histograms of file-level operations.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#ifdef MYGIT_MEM_STATS
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+// =============================================================================
+// PHASES & SITES
+// Code marks what it is doing with a scoped memScope; allocations made while
+// the scope is active are charged to its phase and to its site label.
+// =============================================================================
+
+enum memPhase {
+    PHASE_OTHER = 0,
+    PHASE_WALK,         // Directory traversal
+    PHASE_COMPARE,      // File content comparison / hashing
+    PHASE_COPY,         // Copying content into or out of storage
+    PHASE_METADATA,     // Reading/writing HEAD and commit metadata
+    PHASE_COUNT
+};
+
+const char* const MEM_PHASE_NAMES[PHASE_COUNT] = {"other", "walk", "compare", "copy", "metadata parse"};
+const int MEM_MAX_SITES = 64;
+
+struct memCounter {
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> bytes{0};
+};
+
+struct memSite {
+    atomic<const char*> label{nullptr};
+    atomic<int> phase{0};
+    memCounter counter;
+};
+
+memCounter memTotal;
+memCounter memByPhase[PHASE_COUNT];
+memSite memSites[MEM_MAX_SITES];
+atomic<int64_t> memLive{0};
+atomic<int64_t> memPeakLive{0};
+
+thread_local int memCurrentPhase = PHASE_OTHER;
+thread_local int memCurrentSite = -1;
+
+/**
+ * Finds (or claims) the slot for a site label. Labels are string literals,
+ * so pointer identity is enough. Never allocates.
+ */
+int memSiteSlot(const char* label, int phase) {
+    for (int i = 0; i < MEM_MAX_SITES; i++) {
+        const char* cur = memSites[i].label.load();
+        if (cur == label && memSites[i].phase.load() == phase) return i;
+        if (cur == nullptr) {
+            const char* expected = nullptr;
+            if (memSites[i].label.compare_exchange_strong(expected, label) || expected == label) {
+                memSites[i].phase = phase;
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+class memScope {
+private:
+    int savedPhase;
+    int savedSite;
+
+public:
+    memScope(memPhase phase, const char* site) : savedPhase(memCurrentPhase), savedSite(memCurrentSite) {
+        memCurrentPhase = phase;
+#ifdef MYGIT_MEM_STATS
+        memCurrentSite = memSiteSlot(site, phase);
+#else
+        (void)site;
+#endif
+    }
+    ~memScope() {
+        memCurrentPhase = savedPhase;
+        memCurrentSite = savedSite;
+    }
+};
+
+// =============================================================================
+// ALLOCATION HOOK (instrumented builds only)
+// =============================================================================
+
+#ifdef MYGIT_MEM_STATS
+
+inline void memRecordAlloc(void* p) {
+    uint64_t size = malloc_usable_size(p);
+    memTotal.count++;
+    memTotal.bytes += size;
+    memByPhase[memCurrentPhase].count++;
+    memByPhase[memCurrentPhase].bytes += size;
+    if (memCurrentSite >= 0) {
+        memSites[memCurrentSite].counter.count++;
+        memSites[memCurrentSite].counter.bytes += size;
+    }
+
+    int64_t live = memLive += size;
+    int64_t peak = memPeakLive.load();
+    while (live > peak && !memPeakLive.compare_exchange_weak(peak, live)) {}
+}
+
+void* operator new(size_t n) {
+    void* p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    memRecordAlloc(p);
+    return p;
+}
+
+void* operator new[](size_t n) { return operator new(n); }
+
+void* operator new(size_t n, const nothrow_t&) noexcept {
+    void* p = malloc(n ? n : 1);
+    if (p) memRecordAlloc(p);
+    return p;
+}
+
+void* operator new[](size_t n, const nothrow_t& t) noexcept { return operator new(n, t); }
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    memLive -= malloc_usable_size(p);
+    free(p);
+}
+
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+void operator delete(void* p, const nothrow_t&) noexcept { operator delete(p); }
+void operator delete[](void* p, const nothrow_t&) noexcept { operator delete(p); }
+
+#endif
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+/**
+ * Peak resident set size of the process in KiB (0 if unavailable).
+ */
+long peakRSSKiB() {
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+void printMemStats() {
+    cerr << "--- memory ---\n";
+    cerr << "peak RSS:          " << peakRSSKiB() << " KiB\n";
+#ifdef MYGIT_MEM_STATS
+    // Snapshot first: printing allocates
+    struct row { const char* label; int phase; uint64_t count, bytes; };
+    uint64_t totalCount = memTotal.count, totalBytes = memTotal.bytes;
+    uint64_t phaseCount[PHASE_COUNT], phaseBytes[PHASE_COUNT];
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        phaseCount[i] = memByPhase[i].count;
+        phaseBytes[i] = memByPhase[i].bytes;
+    }
+    row rows[MEM_MAX_SITES];
+    int nrows = 0;
+    for (; nrows < MEM_MAX_SITES && memSites[nrows].label.load(); nrows++) {
+        rows[nrows] = {memSites[nrows].label.load(), memSites[nrows].phase.load(),
+                       memSites[nrows].counter.count.load(), memSites[nrows].counter.bytes.load()};
+    }
+    vector<row> sites(rows, rows + nrows);
+
+    cerr << "peak live heap:    " << memPeakLive.load() / 1024 << " KiB\n";
+    cerr << "allocations:       " << totalCount << "\n";
+    cerr << "bytes allocated:   " << totalBytes << "\n";
+    cerr << "by phase:\n";
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        if (phaseCount[i] == 0) continue;
+        cerr << "  " << MEM_PHASE_NAMES[i] << ": " << phaseCount[i] << " allocs, " << phaseBytes[i] << " bytes\n";
+    }
+
+    sort(sites.begin(), sites.end(), [](const row& a, const row& b) { return a.bytes > b.bytes; });
+    cerr << "top sites:\n";
+    for (size_t i = 0; i < sites.size() && i < 10; i++) {
+        cerr << "  " << sites[i].label << " [" << MEM_PHASE_NAMES[sites[i].phase] << "]: "
+             << sites[i].count << " allocs, " << sites[i].bytes << " bytes\n";
+    }
+#else
+    cerr << "(allocation counters require building with -DMYGIT_MEM_STATS)\n";
+#endif
+}
+
+// =============================================================================
+// LATENCY HISTOGRAMS
+// HDR-style buckets: each power of two is split into LAT_SUB_BUCKETS linear
+// sub-buckets, so every recorded value is within ~1/LAT_SUB_BUCKETS of its bucket.
+// =============================================================================
+
+enum latencyOp {
+    LAT_STAT = 0,
+    LAT_OPEN,
+    LAT_READ,
+    LAT_COPY,
+    LAT_MKDIR,
+    LAT_COUNT
+};
+
+const char* const LAT_OP_NAMES[LAT_COUNT] = {"stat", "open", "read", "copy", "mkdir"};
+const int LAT_SUB_BITS = 3;
+const int LAT_SUB_BUCKETS = 1 << LAT_SUB_BITS;
+const int LAT_BUCKETS = 64 * LAT_SUB_BUCKETS;
+
+bool latencyEnabled = false;
+
+struct latencyHistogram {
+    atomic<uint64_t> buckets[LAT_BUCKETS] = {};
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> sum{0};
+    atomic<uint64_t> max{0};
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < LAT_SUB_BUCKETS) return (int)ns;
+        int msb = 63 - __builtin_clzll(ns);
+        int sub = (int)((ns >> (msb - LAT_SUB_BITS)) & (LAT_SUB_BUCKETS - 1));
+        return (msb - LAT_SUB_BITS + 1) * LAT_SUB_BUCKETS + sub;
+    }
+
+    // Upper edge of a bucket, used when reporting percentiles
+    static uint64_t bucketLimit(int b) {
+        if (b < LAT_SUB_BUCKETS) return (uint64_t)b;
+        int msb = b / LAT_SUB_BUCKETS + LAT_SUB_BITS - 1;
+        uint64_t base = 1ull << msb;
+        return base + ((uint64_t)(b % LAT_SUB_BUCKETS) + 1) * (base >> LAT_SUB_BITS) - 1;
+    }
+
+    void record(uint64_t ns) {
+        buckets[bucketOf(ns)]++;
+        count++;
+        sum += ns;
+        uint64_t cur = max.load();
+        while (ns > cur && !max.compare_exchange_weak(cur, ns)) {}
+    }
+
+    uint64_t percentile(double q) const {
+        uint64_t n = count.load(), target = (uint64_t)ceil(q * n), seen = 0;
+        for (int b = 0; b < LAT_BUCKETS; b++) {
+            seen += buckets[b].load();
+            if (seen >= target && seen > 0) return min(bucketLimit(b), max.load());
+        }
+        return max.load();
+    }
+};
+
+latencyHistogram latencyByOp[LAT_COUNT];
+
+/**
+ * Times the enclosing scope as one operation of the given kind (only when --latency is on).
+ */
+class latencyTimer {
+private:
+    latencyOp op;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit latencyTimer(latencyOp kind) : op(kind) {
+        if (latencyEnabled) start = chrono::steady_clock::now();
+    }
+    ~latencyTimer() {
+        if (!latencyEnabled) return;
+        auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        latencyByOp[op].record((uint64_t)ns);
+    }
+};
+
+string formatNanos(uint64_t ns) {
+    char buf[32];
+    if (ns < 10000) snprintf(buf, sizeof(buf), "%lluns", (unsigned long long)ns);
+    else if (ns < 10000000) snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+    else snprintf(buf, sizeof(buf), "%.1fms", ns / 1e6);
+    return buf;
+}
+
+void printLatencyStats() {
+    cerr << "--- latency ---\n";
+    cerr << "op       count      mean       p50       p90       p99     p99.9       max\n";
+    for (int i = 0; i < LAT_COUNT; i++) {
+        const latencyHistogram& h = latencyByOp[i];
+        uint64_t n = h.count.load();
+        if (n == 0) continue;
+
+        char line[160];
+        snprintf(line, sizeof(line), "%-6s %7llu %9s %9s %9s %9s %9s %9s\n", LAT_OP_NAMES[i],
+                 (unsigned long long)n, formatNanos(h.sum.load() / n).c_str(),
+                 formatNanos(h.percentile(0.50)).c_str(), formatNanos(h.percentile(0.90)).c_str(),
+                 formatNanos(h.percentile(0.99)).c_str(), formatNanos(h.percentile(0.999)).c_str(),
+                 formatNanos(h.max.load()).c_str());
+        cerr << line;
+    }
+}
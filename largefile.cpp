@@ -0,0 +1,125 @@
+/**
+ * LARGEFILE.CPP
+ * Purpose: Out-of-line storage for large files. Files at or above the
+ * configured threshold are stored once in .git/large/, keyed by content hash,
+ * and snapshots carry only a small pointer file in their place.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include "config.cpp"
+#include "hash.cpp"
+#include "instrument.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// POINTER FORMAT
+//   mygit-large v1
+//   <blake3 hex> <size in bytes>
+// =============================================================================
+
+const string LARGE_MAGIC = "mygit-large v1";
+const uintmax_t LARGE_POINTER_MAX = 128;
+const uint64_t LARGE_DEFAULT_THRESHOLD = 64ull << 20;
+
+struct largePointer {
+    string hash;
+    uintmax_t size = 0;
+};
+
+/**
+ * Files at or above this size are stored out of line ("largefile.threshold").
+ */
+uint64_t largeThreshold() {
+    static uint64_t threshold = configSize("largefile.threshold", LARGE_DEFAULT_THRESHOLD);
+    return threshold;
+}
+
+fs::path largeObjectPath(const string& hash) {
+    return fs::path(".git") / "large" / hash.substr(0, 2) / hash.substr(2);
+}
+
+/**
+ * Reads a pointer file. Returns false for any regular file that is not one.
+ */
+bool readLargePointer(const fs::path& p, largePointer& ptr) {
+    error_code ec;
+    uintmax_t size = fs::file_size(p, ec);
+    if (ec || size > LARGE_POINTER_MAX || size < LARGE_MAGIC.size()) return false;
+
+    ifstream in(p, ios::binary);
+    string magic;
+    if (!getline(in, magic) || magic != LARGE_MAGIC) return false;
+    return bool(in >> ptr.hash >> ptr.size) && ptr.hash.size() == 64;
+}
+
+/**
+ * Same as readLargePointer, for content already in memory (e.g. a packed blob).
+ */
+bool parseLargePointer(const string& content, largePointer& ptr) {
+    if (content.size() > LARGE_POINTER_MAX || content.compare(0, LARGE_MAGIC.size() + 1, LARGE_MAGIC + "\n") != 0) {
+        return false;
+    }
+    istringstream in(content.substr(LARGE_MAGIC.size() + 1));
+    return bool(in >> ptr.hash >> ptr.size) && ptr.hash.size() == 64;
+}
+
+/**
+ * Streams a file into the large-object area (once per distinct content)
+ * and returns its pointer.
+ */
+largePointer storeLargeObject(const fs::path& src) {
+    largePointer ptr;
+    ptr.hash = hashFile(src);
+    ptr.size = fs::file_size(src);
+
+    fs::path obj = largeObjectPath(ptr.hash);
+    if (!fs::exists(obj)) {
+        // Copy to a temporary name first so a crash never leaves a truncated object;
+        // the name is per process and thread since others may store the same content
+        fs::create_directories(obj.parent_path());
+        fs::path tmp = obj;
+        tmp += "." + to_string(getpid()) + "-" + to_string(std::hash<thread::id>()(this_thread::get_id()));
+        fs::copy_file(src, tmp, fs::copy_options::overwrite_existing);
+        fs::rename(tmp, obj);
+    }
+    return ptr;
+}
+
+/**
+ * Places a working-tree file at `dst` (staging area, stash), storing it out of
+ * line with a pointer if it is at least the large-file threshold.
+ */
+void stageFile(const fs::path& src, const fs::path& dst) {
+    {
+        latencyTimer t(LAT_MKDIR);
+        fs::create_directories(dst.parent_path());
+    }
+    if (fs::file_size(src) < largeThreshold()) {
+        latencyTimer t(LAT_COPY);
+        fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
+        return;
+    }
+
+    largePointer ptr = storeLargeObject(src);
+    ofstream out(dst, ios::binary | ios::trunc);
+    out << LARGE_MAGIC << "\n" << ptr.hash << " " << ptr.size << "\n";
+}
+
+/**
+ * Checks whether a real file has the content a pointer refers to.
+ */
+bool matchesLargePointer(const fs::path& file, const largePointer& ptr) {
+    error_code ec;
+    if (fs::file_size(file, ec) != ptr.size || ec) return false;
+    return hashFile(file) == ptr.hash;
+}
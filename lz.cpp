@@ -0,0 +1,128 @@
+/**
+ * LZ.CPP
+ * Purpose: Small byte-oriented LZ77 compressor for archived history.
+ * Fast enough to run during maintenance and, more importantly, fast to
+ * decompress when an archived snapshot is read back.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+// =============================================================================
+// STREAM FORMAT
+// A sequence of: token | [extra literal length] | literals | offset (u16 LE)
+//                | [extra match length]
+// token high nibble = literal count, low nibble = match length - LZ_MIN_MATCH;
+// a nibble of 15 is followed by bytes of 255 (and one final byte < 255) that
+// add to it. The last sequence has literals only and ends the stream.
+// =============================================================================
+
+const size_t LZ_MIN_MATCH = 4;
+const size_t LZ_MAX_OFFSET = 65535;
+const int LZ_HASH_BITS = 14;
+
+inline uint32_t lzRead32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint32_t lzHash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+inline void lzPutLength(string& out, size_t n) {
+    while (n >= 255) { out += (char)255; n -= 255; }
+    out += (char)n;
+}
+
+void lzEmit(string& out, const uint8_t* literals, size_t litLen, size_t offset, size_t matchLen) {
+    size_t m = matchLen ? matchLen - LZ_MIN_MATCH : 0;
+    uint8_t token = (uint8_t)((min<size_t>(litLen, 15) << 4) | min<size_t>(m, 15));
+    out += (char)token;
+    if (litLen >= 15) lzPutLength(out, litLen - 15);
+    out.append(reinterpret_cast<const char*>(literals), litLen);
+    if (!matchLen) return;
+
+    out += (char)(offset & 0xFF);
+    out += (char)(offset >> 8);
+    if (m >= 15) lzPutLength(out, m - 15);
+}
+
+/**
+ * Compresses `n` bytes. Incompressible input grows by well under 1%.
+ */
+string lzCompress(const char* data, size_t n) {
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+    string out;
+    out.reserve(n / 2 + 16);
+    vector<uint32_t> table(1u << LZ_HASH_BITS, UINT32_MAX);
+
+    size_t pos = 0, anchor = 0;
+    while (n >= LZ_MIN_MATCH && pos + LZ_MIN_MATCH <= n) {
+        uint32_t h = lzHash(lzRead32(in + pos));
+        uint32_t cand = table[h];
+        table[h] = (uint32_t)pos;
+
+        if (cand == UINT32_MAX || pos - cand > LZ_MAX_OFFSET || lzRead32(in + cand) != lzRead32(in + pos)) {
+            pos++;
+            continue;
+        }
+
+        size_t len = LZ_MIN_MATCH;
+        while (pos + len < n && in[cand + len] == in[pos + len]) len++;
+        lzEmit(out, in + anchor, pos - anchor, pos - cand, len);
+        pos += len;
+        anchor = pos;
+    }
+    lzEmit(out, in + anchor, n - anchor, 0, 0);
+    return out;
+}
+
+/**
+ * Decompresses into exactly `rawSize` bytes. Returns false on corrupt input.
+ */
+bool lzDecompress(const char* data, size_t n, size_t rawSize, string& out) {
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = in + n;
+    out.clear();
+    out.reserve(rawSize);
+
+    auto readLength = [&](size_t base, size_t& len) {
+        len = base;
+        if (base != 15) return true;
+        for (;;) {
+            if (in >= end) return false;
+            uint8_t b = *in++;
+            len += b;
+            if (b != 255) return true;
+        }
+    };
+
+    while (in < end) {
+        uint8_t token = *in++;
+        size_t litLen, matchLen;
+        if (!readLength(token >> 4, litLen) || (size_t)(end - in) < litLen) return false;
+        out.append(reinterpret_cast<const char*>(in), litLen);
+        in += litLen;
+        if (in == end) break;
+
+        if (end - in < 2) return false;
+        size_t offset = in[0] | (size_t)in[1] << 8;
+        in += 2;
+        if (!readLength(token & 15, matchLen)) return false;
+        matchLen += LZ_MIN_MATCH;
+        if (offset == 0 || offset > out.size() || out.size() + matchLen > rawSize) return false;
+
+        // Byte by byte: matches may overlap their own output
+        size_t from = out.size() - offset;
+        for (size_t i = 0; i < matchLen; i++) out += out[from + i];
+    }
+    return out.size() == rawSize;
+}
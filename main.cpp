@@ -7,6 +7,8 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <chrono>
+#include <cstdlib>
 #include "manager.cpp"
 
 using namespace std;
@@ -28,8 +30,20 @@ void displayHelp() {
     cout << "  mygit add <. | file_names>       " << "Stage files for commit" << endl;
     cout << "  mygit commit -m \"message\"        " << "Commit staged changes" << endl;
     cout << "  mygit status                     " << "Check status of working tree" << endl;
-    cout << "  mygit log                        " << "View commit history" << endl;
+    cout << "  mygit log [--stat]               " << "View commit history" << endl;
     cout << "  mygit revert <hash | HEAD>       " << "Revert to a previous state" << endl;
+    cout << "  mygit cherry-pick <commit>       " << "Apply the changes of a commit onto HEAD" << endl;
+    cout << "  mygit rebase <onto>              " << "Replay local commits on top of another commit" << endl;
+    cout << "  mygit stash <push | pop | list>  " << "Shelve local changes" << endl;
+    cout << "  mygit reset [--soft|--mixed|--hard] <commit>  " << "Move HEAD to a commit" << endl;
+    cout << "  mygit clean <-f | -n>            " << "Remove (-f) or list (-n) untracked files" << endl;
+    cout << "  mygit reflog [--at \"time\"]       " << "Show HEAD history (or HEAD at a time)" << endl;
+    cout << "  mygit show <commit>:<path>       " << "Print a file as it was in a commit" << endl;
+    cout << "  mygit maintenance <run | start | stop>  " << "Incremental upkeep (run: [--task name] [--time-limit s])" << endl;
+    cout << "  mygit migrate                    " << "Convert legacy snapshots to packed storage" << endl;
+    cout << "Global flags (before the command):" << endl;
+    cout << "  --mem-stats                      " << "Report peak memory (and allocations in -DMYGIT_MEM_STATS builds)" << endl;
+    cout << "  --latency                        " << "Report latency histograms of file operations" << endl;
     cout << "----------------------------------------------\n" << endl;
 }
 
@@ -37,7 +51,22 @@ void displayHelp() {
 // MAIN ENTRY POINT
 // =============================================================================
 int main(int argc, char *argv[]) {
-    gitClass myGit;
+    // Editor integrations run status/log on every save, so startup is kept minimal:
+    // no C stdio sync, and nothing touches the filesystem before dispatch.
+    auto started = chrono::steady_clock::now();
+    ios::sync_with_stdio(false);
+
+    // Global flags go before the subcommand; anything after it (a file named
+    // --latency, a commit message) belongs to the subcommand
+    bool memStats = false;
+    int first = 1;
+    for (; first < argc; first++) {
+        if (string(argv[first]) == "--mem-stats") memStats = true;
+        else if (string(argv[first]) == "--latency") latencyEnabled = true;
+        else break;
+    }
+    for (int i = first; i < argc; i++) argv[i - first + 1] = argv[i];
+    argc -= first - 1;
 
     // Handle case with no arguments
     if (argc < 2) {
@@ -46,6 +75,7 @@ int main(int argc, char *argv[]) {
     }
 
     string command = string(argv[1]);
+    gitClass myGit;
 
     // 1. INIT
     if (command == "init") {
@@ -95,7 +125,12 @@ int main(int argc, char *argv[]) {
 
     // 5. LOG
     else if (command == "log") {
-        myGit.gitLog();
+        if (argc == 2 || (argc == 3 && string(argv[2]) == "--stat")) {
+            myGit.gitLog(argc == 3);
+        } else {
+            cout << RED << "Error: Invalid log syntax." << END << endl;
+            cout << "Correct usage: mygit log [--stat]" << endl;
+        }
     }
 
     // 6. STATUS
@@ -103,11 +138,141 @@ int main(int argc, char *argv[]) {
         myGit.gitStatus();
     }
 
-    // 7. INVALID COMMAND
+    // 7. CHERRY-PICK
+    else if (command == "cherry-pick") {
+        if (argc == 3) {
+            if (myGit.gitCherryPick(string(argv[2]))) {
+                cout << GRN << "Successfully cherry-picked " << argv[2] << "." << END << endl;
+            }
+        } else {
+            cout << RED << "Error: Please specify the commit to cherry-pick." << END << endl;
+        }
+    }
+
+    // 8. REBASE
+    else if (command == "rebase") {
+        if (argc == 3) {
+            myGit.gitRebase(string(argv[2]));
+        } else {
+            cout << RED << "Error: Please specify the commit to rebase onto." << END << endl;
+        }
+    }
+
+    // 9. STASH
+    else if (command == "stash") {
+        string sub = (argc >= 3) ? string(argv[2]) : "push";
+        if (sub == "push" && argc == 5 && string(argv[3]) == "-m") {
+            myGit.gitStashPush(string(argv[4]));
+        } else if (sub == "push" && argc <= 3) {
+            myGit.gitStashPush("");
+        } else if (sub == "pop" && argc == 3) {
+            myGit.gitStashPop();
+        } else if (sub == "list" && argc == 3) {
+            myGit.gitStashList();
+        } else {
+            cout << RED << "Error: Invalid stash syntax." << END << endl;
+            cout << "Correct usage: mygit stash <push [-m \"message\"] | pop | list>" << endl;
+        }
+    }
+
+    // 10. REFLOG
+    else if (command == "reflog") {
+        if (argc == 2) {
+            myGit.gitReflog();
+        } else if (argc == 4 && string(argv[2]) == "--at") {
+            myGit.gitReflogAt(string(argv[3]));
+        } else {
+            cout << RED << "Error: Invalid reflog syntax." << END << endl;
+            cout << "Correct usage: mygit reflog [--at \"YYYY/MM/DD HH:MM\"]" << endl;
+        }
+    }
+
+    // 11. RESET
+    else if (command == "reset") {
+        string mode = (argc == 4) ? string(argv[2]) : "--mixed";
+        if ((argc == 3 || argc == 4) && (mode == "--soft" || mode == "--mixed" || mode == "--hard")) {
+            myGit.gitReset(mode, string(argv[argc - 1]));
+        } else {
+            cout << RED << "Error: Invalid reset syntax." << END << endl;
+            cout << "Correct usage: mygit reset [--soft | --mixed | --hard] <commit>" << endl;
+        }
+    }
+
+    // 12. CLEAN
+    else if (command == "clean") {
+        // Deleting needs -f, as in git; -n only lists what would go
+        bool force = false, dryRun = false, valid = true;
+        for (int i = 2; i < argc; i++) {
+            string a = argv[i];
+            if (a == "-f") force = true;
+            else if (a == "-n") dryRun = true;
+            else if (a == "-fn" || a == "-nf") force = dryRun = true;
+            else valid = false;
+        }
+        if (valid && (force || dryRun)) {
+            myGit.gitClean(dryRun);
+        } else {
+            cout << RED << "Error: Invalid clean syntax." << END << endl;
+            if (argc == 2) cout << "Refusing to delete untracked files without -f." << endl;
+            cout << "Correct usage: mygit clean <-f | -n>" << endl;
+        }
+    }
+
+    // 13. MAINTENANCE
+    else if (command == "maintenance") {
+        string action = (argc >= 3) ? string(argv[2]) : "";
+        string task;
+        double timeLimit = 0;
+        bool valid = (action == "run" || ((action == "start" || action == "stop") && argc == 3));
+        for (int i = 3; valid && action == "run" && i < argc; i += 2) {
+            string opt = argv[i];
+            if (i + 1 >= argc) valid = false;
+            else if (opt == "--task") task = argv[i + 1];
+            else if (opt == "--time-limit") timeLimit = atof(argv[i + 1]);
+            else valid = false;
+        }
+        if (valid) {
+            myGit.gitMaintenance(action, task, timeLimit);
+        } else {
+            cout << RED << "Error: Invalid maintenance syntax." << END << endl;
+            cout << "Correct usage: mygit maintenance <run [--task stat-cache|compact|pack|archive|prune] [--time-limit seconds] | start | stop>" << endl;
+        }
+    }
+
+    // 14. SHOW
+    else if (command == "show") {
+        if (argc == 3) {
+            myGit.gitShow(string(argv[2]));
+        } else {
+            cout << RED << "Error: Invalid show syntax." << END << endl;
+            cout << "Correct usage: mygit show <commit>:<path>" << endl;
+        }
+    }
+
+    // 15. MIGRATE
+    else if (command == "migrate") {
+        if (argc == 2) {
+            myGit.gitMigrate();
+        } else {
+            cout << RED << "Error: Invalid migrate syntax." << END << endl;
+            cout << "Correct usage: mygit migrate" << endl;
+        }
+    }
+
+    // 16. INVALID COMMAND
     else {
         cout << RED << "Unknown command: '" << command << "'" << END << endl;
         displayHelp();
     }
 
+    if (memStats) printMemStats();
+    if (latencyEnabled) printLatencyStats();
+
+    // MYGIT_TIMING=1 reports how long the command took inside the process
+    if (getenv("MYGIT_TIMING")) {
+        auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started).count();
+        cerr << "mygit " << command << ": " << us << " us in-process" << endl;
+    }
+
     return 0;
 }
@@ -0,0 +1,626 @@
+/**
+ * MAINTENANCE.CPP
+ * Purpose: Incremental repository upkeep that runs off the critical path of
+ * add/commit. Each task works in small units and stops when its time box runs
+ * out, resuming where it left off on the next run. All I/O and CPU use is
+ * throttled to the configured rates so background runs stay out of the way.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include <functional>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// BUDGET & THROTTLING
+// =============================================================================
+
+struct maintenanceLimits {
+    double seconds = 10;            // "maintenance.timeLimit": time box of one run
+    uint64_t ioBytesPerSec = 0;     // "maintenance.ioRate": 0 = unthrottled
+    unsigned cpuPercent = 100;      // "maintenance.cpuPercent": share of one core
+};
+
+maintenanceLimits maintenanceLimitsFromConfig() {
+    maintenanceLimits limits;
+    try {
+        limits.seconds = stod(configValue("maintenance.timeLimit", "10"));
+        limits.cpuPercent = (unsigned)stoul(configValue("maintenance.cpuPercent", "100"));
+    } catch (const exception&) {}
+    limits.ioBytesPerSec = configSize("maintenance.ioRate", 0);
+    limits.cpuPercent = max(1u, min(100u, limits.cpuPercent));
+    return limits;
+}
+
+double processCpuSeconds() {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/**
+ * Tracks the time box of a run and paces work to the I/O and CPU limits.
+ * Tasks call charge() after every unit of work; it sleeps when the run is
+ * ahead of its allowance and returns false once the time box is used up.
+ */
+class maintenanceBudget {
+private:
+    maintenanceLimits limits;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double cpuStart = processCpuSeconds();
+    uint64_t bytes = 0;
+
+    double elapsed() const {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+public:
+    explicit maintenanceBudget(const maintenanceLimits& l) : limits(l) {}
+
+    bool expired() const { return elapsed() >= limits.seconds; }
+
+    bool charge(uint64_t ioBytes) {
+        bytes += ioBytes;
+
+        // The slower of the two limits decides how long this much work must take
+        double due = 0;
+        if (limits.ioBytesPerSec) due = max(due, (double)bytes / limits.ioBytesPerSec);
+        if (limits.cpuPercent < 100) due = max(due, (processCpuSeconds() - cpuStart) * 100.0 / limits.cpuPercent);
+
+        double wait = min(due - elapsed(), limits.seconds - elapsed());
+        if (wait > 0) this_thread::sleep_for(chrono::duration<double>(wait));
+        return !expired();
+    }
+};
+
+// =============================================================================
+// TASK STATE
+// Progress markers live in .git/maintenance/ so interrupted work resumes.
+// =============================================================================
+
+fs::path maintenanceDir() {
+    return fs::path(".git") / "maintenance";
+}
+
+set<string> loadDoneList(const string& task) {
+    set<string> done;
+    ifstream in(maintenanceDir() / (task + ".done"));
+    string line;
+    while (getline(in, line)) if (!line.empty()) done.insert(line);
+    return done;
+}
+
+void markDone(const string& task, const string& id) {
+    fs::create_directories(maintenanceDir());
+    ofstream out(maintenanceDir() / (task + ".done"), ios::app);
+    out << id << "\n";
+}
+
+/**
+ * Every commit directory on disk (HEAD chain, stash entries and unreachable leftovers).
+ */
+vector<string> allCommitIDs() {
+    vector<string> ids;
+    fs::path commits = fs::path(".git") / "commits";
+    error_code ec;
+    for (const auto& e : fs::directory_iterator(commits, ec)) {
+        if (e.is_directory()) ids.push_back(e.path().filename().string());
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+ * Replaces `file` with a hard link to `from` (same content). The link is made
+ * under a temporary name and swapped in atomically.
+ */
+bool linkInPlace(const fs::path& from, const fs::path& file) {
+    fs::path tmp = file;
+    tmp += ".compact";
+    error_code ec;
+    fs::create_hard_link(from, tmp, ec);
+    if (!ec) fs::rename(tmp, file, ec);
+    if (ec) fs::remove(tmp, ec);
+    return !ec;
+}
+
+uintmax_t treeBytes(const fs::path& dir) {
+    uintmax_t total = 0;
+    error_code ec;
+    for (const auto& e : fs::recursive_directory_iterator(dir, ec)) {
+        if (e.is_regular_file(ec)) total += e.file_size(ec);
+    }
+    return total;
+}
+
+// =============================================================================
+// TASKS
+// Each returns the number of units it completed and sets `finished` when no
+// work is left.
+// =============================================================================
+
+/**
+ * Precomputes the `log --stat` cache for commits on the HEAD chain.
+ */
+size_t refreshStatCache(maintenanceBudget& budget, const vector<string>&, bool& finished) {
+    commitNodeList list;
+    size_t units = 0;
+    finished = false;
+
+    for (const auto& id : list.history()) {
+        if (fs::exists(statCachePath(id))) continue;
+
+        vector<fileStat> stats = computeCommitStat(id);
+        saveCachedStat(id, stats);
+        units++;
+
+        uint64_t read = 0;
+        error_code ec;
+        for (const auto& st : stats) read += fs::file_size(fs::path(".git") / "commits" / id / "Data" / st.path, ec);
+        if (!budget.charge(read)) return units;
+    }
+    finished = true;
+    return units;
+}
+
+/**
+ * Replaces snapshot files that duplicate the parent's copy of the same path
+ * with hard links to it (repositories written before snapshot inheritance
+ * used links keep a full copy per commit).
+ */
+size_t compactSnapshots(maintenanceBudget& budget, const vector<string>&, bool& finished) {
+    set<string> done = loadDoneList("compact");
+    fs::path commitsRoot = fs::path(".git") / "commits";
+    size_t units = 0;
+    finished = false;
+
+    for (const auto& id : allCommitIDs()) {
+        if (done.count(id)) continue;
+
+        commitInfo info;
+        fs::path data = commitsRoot / id / "Data";
+        if (readCommitInfo(id, info) && !info.parent.empty() && fs::exists(data)) {
+            fs::path parentData = commitsRoot / info.parent / "Data";
+            for (const auto& t : readTree(id)) {
+                fs::path theirs = parentData / t.first;
+                error_code ec;
+                if (!fs::exists(theirs, ec) || fs::equivalent(t.second, theirs, ec)) continue;
+
+                uintmax_t size = fs::file_size(t.second, ec);
+                if (filesAreSame(t.second, theirs) && fs::file_size(theirs, ec) == size) linkInPlace(theirs, t.second);
+                // Stopping mid-commit is fine: the commit is simply revisited next run
+                if (!budget.charge(2 * size)) return units;
+            }
+        }
+        markDone("compact", id);
+        units++;
+        if (!budget.charge(0)) return units;
+    }
+    finished = true;
+    return units;
+}
+
+/**
+ * Packs the content of HEAD-chain commits, oldest first, into one new segment
+ * per run and writes each commit's manifest once its blobs are published.
+ * Files hard-linked from an already packed parent reuse its hash instead of
+ * being re-read. Ends by restoring the geometric segment sequence.
+ */
+size_t packHistory(maintenanceBudget& budget, const vector<string>&, bool& finished) {
+    commitNodeList list;
+    vector<string> ids = list.history();
+    reverse(ids.begin(), ids.end());
+
+    segmentStore store;
+    store.refreshIndex();
+    segmentWriter writer = store.beginSegment();
+    fs::path commitsRoot = fs::path(".git") / "commits";
+    map<string, commitManifest> pending;
+    finished = true;
+
+    for (const auto& id : ids) {
+        if (fs::exists(manifestPath(id))) continue;
+        if (budget.expired()) { finished = false; break; }
+
+        commitInfo info;
+        readCommitInfo(id, info);
+        commitManifest parent;
+        if (pending.count(info.parent)) parent = pending[info.parent];
+        else if (!info.parent.empty()) readManifest(info.parent, parent);
+
+        commitManifest manifest;
+        uint64_t read = 0;
+        for (const auto& t : readTree(id)) {
+            error_code ec;
+            auto p = parent.find(t.first);
+            manifestEntry m;
+            if (p != parent.end() && fs::equivalent(t.second, commitsRoot / info.parent / "Data" / t.first, ec)) {
+                m = p->second;
+            } else {
+                m = {hashFile(t.second), fs::file_size(t.second)};
+                read += m.size;
+            }
+            if (!writer.has(m.hash) && !store.contains(m.hash)) {
+                writer.addFile(m.hash, t.second);
+                read += m.size;
+            }
+            manifest[t.first] = m;
+        }
+        pending[id] = manifest;
+        if (!budget.charge(read)) { finished = false; break; }
+    }
+
+    // Manifests only point at blobs in a published segment
+    store.addSegment(writer);
+    for (const auto& p : pending) writeManifest(p.first, p.second);
+
+    store.compactGeometric(segmentFactor(), [&](uint64_t bytes) { budget.charge(bytes); });
+    return pending.size();
+}
+
+/**
+ * Moves old snapshots to cold storage. A packed commit on the HEAD chain is
+ * archived when it is at least "archive.afterCommits" commits behind HEAD or,
+ * if "archive.afterDays" is set, older than that many days. Its blobs are
+ * written LZ-compressed into one archive segment per run and then its Data/
+ * directory is removed; readers fall back to the manifest. HEAD itself always
+ * stays loose.
+ */
+size_t archiveHistory(maintenanceBudget& budget, const vector<string>&, bool& finished) {
+    uint64_t afterCommits = max<uint64_t>(1, configSize("archive.afterCommits", 1000));
+    double afterDays = 0;
+    try { afterDays = stod(configValue("archive.afterDays", "0")); }
+    catch (const exception&) {}
+    time_t cutoff = time(nullptr) - (time_t)(afterDays * 86400);
+
+    commitNodeList list;
+    vector<string> ids = list.history();
+    fs::path commitsRoot = fs::path(".git") / "commits";
+    vector<string> eligible;
+    for (size_t i = 1; i < ids.size(); i++) {
+        if (!fs::exists(commitsRoot / ids[i] / "Data") || !fs::exists(manifestPath(ids[i]))) continue;
+        commitInfo info;
+        bool old = i >= afterCommits;
+        if (!old && afterDays > 0 && readCommitInfo(ids[i], info)) {
+            time_t when = parse_time(info.time);
+            old = when >= 0 && when < cutoff;
+        }
+        if (old) eligible.push_back(ids[i]);
+    }
+    reverse(eligible.begin(), eligible.end());
+
+    segmentStore store;
+    store.refreshIndex();
+    segmentWriter writer = store.beginSegment(true);
+    vector<string> archived;
+    finished = true;
+
+    for (const auto& id : eligible) {
+        if (budget.expired()) { finished = false; break; }
+
+        commitManifest manifest;
+        if (!readManifest(id, manifest)) continue;
+        fs::path data = commitsRoot / id / "Data";
+        uint64_t read = 0;
+        vector<pair<string, fs::path>> todo;
+        for (const auto& m : manifest) {
+            if (writer.has(m.second.hash) || store.contains(m.second.hash, true)) continue;
+            todo.push_back({m.second.hash, data / m.first});
+            read += m.second.size;
+        }
+
+        vector<fs::path> files;
+        for (const auto& t : todo) files.push_back(t.second);
+        prefetcher ahead(move(files), PREFETCH_DATA, PREFETCH_WINDOW);
+        for (size_t i = 0; i < todo.size(); i++) {
+            ahead.consumed(i);
+            writer.addFile(todo[i].first, todo[i].second);
+        }
+        archived.push_back(id);
+        if (!budget.charge(read)) { finished = false; break; }
+    }
+
+    // Loose copies are only dropped once the archive segment is published and
+    // synced, and the manifest that replaces them is on disk too
+    store.addSegment(writer);
+    vector<string> ready;
+    for (const auto& id : archived) {
+        if (syncPath(manifestPath(id)) && syncPath(commitsRoot / id)) ready.push_back(id);
+    }
+
+    // HEAD stays loose even if a command moved it onto one of these commits
+    // meanwhile: HEAD is checked and the Data/ trees are moved aside under the
+    // metadata lock, and only deleted once it is released
+    fs::path trash = maintenanceDir() / "archived";
+    metadata().update([&]() {
+        string head = readHEAD();
+        for (const auto& id : ready) {
+            if (id == head) continue;
+            error_code ec;
+            fs::create_directories(trash, ec);
+            fs::rename(commitsRoot / id / "Data", trash / id, ec);
+        }
+        return metaTable();
+    });
+    error_code ec;
+    fs::remove_all(trash, ec);
+
+    store.compactGeometric(segmentFactor(), [&](uint64_t bytes) { budget.charge(bytes); });
+    return archived.size();
+}
+
+/**
+ * Deletes commits that nothing can reach any more. Roots are HEAD, the given
+ * extra roots (stash entries) and every reflog entry younger than
+ * "maintenance.reflogExpire" days. Commits modified within the last hour are
+ * kept so a commit that is still being written is never touched.
+ * Reachability is decided under the metadata lock, so no command can move
+ * HEAD onto a commit while it is taken out; doomed commits are moved aside
+ * there and deleted after the lock is released.
+ */
+size_t pruneUnreachable(maintenanceBudget& budget, const vector<string>& roots, bool& finished) {
+    finished = false;
+    double expireDays = 90;
+    try { expireDays = stod(configValue("maintenance.reflogExpire", "90")); }
+    catch (const exception&) {}
+    time_t cutoff = time(nullptr) - (time_t)(expireDays * 86400);
+
+    // Commits a previous run took out but did not get to delete
+    fs::path trash = maintenanceDir() / "pruned";
+    error_code ec;
+    if (fs::exists(trash, ec)) {
+        uintmax_t bytes = treeBytes(trash);
+        fs::remove_all(trash, ec);
+        if (!budget.charge(bytes)) return 0;
+    }
+
+    fs::path commitsRoot = fs::path(".git") / "commits";
+    vector<string> taken;
+    metadata().update([&]() {
+        vector<string> starts(roots);
+        starts.push_back(readHEAD());
+
+        reflog log;
+        for (uint64_t n = log.size(); n-- > 0;) {
+            reflog::entry e;
+            if (!log.read(n, e) || e.time < cutoff) break;     // Records are ordered by time
+            starts.push_back(e.newID);
+            starts.push_back(e.oldID);
+        }
+
+        set<string> reachable;
+        commitInfo info;
+        for (const auto& s : starts) {
+            for (string id = s; !reachable.count(id) && readCommitInfo(id, info); id = info.parent) reachable.insert(id);
+        }
+
+        metaTable changes;
+        auto grace = fs::file_time_type::clock::now() - chrono::hours(1);
+        for (const auto& id : allCommitIDs()) {
+            if (reachable.count(id)) continue;
+
+            fs::path dir = commitsRoot / id;
+            error_code ec;
+            if (fs::last_write_time(dir, ec) > grace || ec) continue;
+
+            fs::create_directories(trash, ec);
+            fs::rename(dir, trash / id, ec);
+            if (ec) continue;
+            eraseCommitInfo(id, changes);
+            taken.push_back(id);
+        }
+        return changes;
+    });
+
+    for (const auto& id : taken) {
+        fs::remove(statCachePath(id), ec);
+        cout << "  pruned " << id << "\n";
+    }
+    for (const auto& id : taken) {
+        uintmax_t bytes = treeBytes(trash / id);
+        fs::remove_all(trash / id, ec);
+        if (!budget.charge(bytes)) return taken.size();
+    }
+    fs::remove(trash, ec);
+    finished = true;
+    return taken.size();
+}
+
+struct maintenanceTask {
+    const char* name;
+    const char* summary;
+    function<size_t(maintenanceBudget&, const vector<string>&, bool&)> run;
+};
+
+const vector<maintenanceTask>& maintenanceTasks() {
+    static const vector<maintenanceTask> tasks = {
+        {"stat-cache", "commit(s) indexed for log --stat", refreshStatCache},
+        {"compact", "commit(s) compacted", compactSnapshots},
+        {"pack", "commit(s) packed into segments", packHistory},
+        {"archive", "commit(s) moved to archive segments", archiveHistory},
+        {"prune", "unreachable commit(s) pruned", pruneUnreachable},
+    };
+    return tasks;
+}
+
+// =============================================================================
+// RUNNER
+// =============================================================================
+
+#ifndef _WIN32
+/**
+ * Holds .git/maintenance/lock for the lifetime of the object so two runs
+ * (e.g. a manual run and the background scheduler) never overlap.
+ */
+class maintenanceLock {
+private:
+    int fd = -1;
+
+public:
+    maintenanceLock() {
+        fs::create_directories(maintenanceDir());
+        fd = open((maintenanceDir() / "lock").c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    ~maintenanceLock() { if (fd >= 0) close(fd); }
+    bool held() const { return fd >= 0; }
+};
+#else
+class maintenanceLock {
+public:
+    bool held() const { return true; }
+};
+#endif
+
+/**
+ * Runs the named task (or all of them, empty name) within one time box.
+ * With all tasks, the first one to run rotates between runs so a task that
+ * never finishes cannot starve the others.
+ */
+bool runMaintenance(const string& only, const maintenanceLimits& limits, const vector<string>& roots) {
+    maintenanceLock lock;
+    if (!lock.held()) {
+        cout << "Another maintenance run is in progress." << endl;
+        return false;
+    }
+
+    const auto& tasks = maintenanceTasks();
+    vector<size_t> order;
+    size_t first = 0;
+    if (only.empty()) {
+        ifstream in(maintenanceDir() / "next");
+        in >> first;
+        for (size_t i = 0; i < tasks.size(); i++) order.push_back((first + i) % tasks.size());
+    } else {
+        for (size_t i = 0; i < tasks.size(); i++) if (only == tasks[i].name) order.push_back(i);
+        if (order.empty()) {
+            cout << "Unknown maintenance task: " << only << endl;
+            return false;
+        }
+    }
+
+    maintenanceBudget budget(limits);
+    for (size_t i : order) {
+        if (budget.expired()) {
+            cout << tasks[i].name << ": skipped (time limit reached)" << '\n';
+            continue;
+        }
+        bool finished = false;
+        size_t units = tasks[i].run(budget, roots, finished);
+        cout << tasks[i].name << ": " << units << " " << tasks[i].summary
+             << (finished ? "" : " (paused, resumes next run)") << '\n';
+        first = (i + 1) % tasks.size();
+    }
+
+    if (only.empty()) ofstream(maintenanceDir() / "next", ios::trunc) << first << "\n";
+    return true;
+}
+
+// =============================================================================
+// BACKGROUND SCHEDULER
+// `maintenance start` detaches a low-priority process that runs all tasks
+// every "maintenance.interval" seconds; its PID is kept in .git/maintenance/pid.
+// =============================================================================
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+
+volatile sig_atomic_t maintenanceStopRequested = 0;
+
+pid_t readSchedulerPid() {
+    ifstream in(maintenanceDir() / "pid");
+    pid_t pid = 0;
+    in >> pid;
+    return (pid > 0 && kill(pid, 0) == 0) ? pid : 0;
+}
+
+/**
+ * Lowers CPU priority and, on Linux, moves the process to the idle I/O class
+ * so the kernel only serves its reads when nothing else is waiting.
+ */
+void lowerSchedulingPriority() {
+    setpriority(PRIO_PROCESS, 0, 19);
+#ifdef SYS_ioprio_set
+    const int IOPRIO_WHO_PROCESS = 1, IOPRIO_CLASS_IDLE = 3, IOPRIO_CLASS_SHIFT = 13;
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
+bool startMaintenanceScheduler(const function<vector<string>()>& roots) {
+    if (pid_t running = readSchedulerPid()) {
+        cout << "Maintenance scheduler already running (pid " << running << ")." << endl;
+        return false;
+    }
+    double interval = 3600;
+    try { interval = max(1.0, stod(configValue("maintenance.interval", "3600"))); }
+    catch (const exception&) {}
+
+    fs::create_directories(maintenanceDir());
+    cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid > 0) {
+        cout << "Maintenance scheduler started (pid " << pid << ", every " << interval << "s)." << endl;
+        return true;
+    }
+
+    // Child: detach from the terminal and log to .git/maintenance/log
+    setsid();
+    lowerSchedulingPriority();
+    int logFd = open((maintenanceDir() / "log").c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    int nullFd = open("/dev/null", O_RDONLY);
+    dup2(nullFd, STDIN_FILENO);
+    dup2(logFd, STDOUT_FILENO);
+    dup2(logFd, STDERR_FILENO);
+    ofstream(maintenanceDir() / "pid", ios::trunc) << getpid() << "\n";
+    signal(SIGTERM, [](int) { maintenanceStopRequested = 1; });
+
+    while (!maintenanceStopRequested && repositoryExists()) {
+        cout << "--- " << get_time() << " ---" << endl;
+        metadata().refresh();
+        runMaintenance("", maintenanceLimitsFromConfig(), roots());
+        cout.flush();
+        for (double slept = 0; slept < interval && !maintenanceStopRequested; slept += 1) sleep(1);
+    }
+    fs::remove(maintenanceDir() / "pid");
+    _exit(0);
+}
+
+bool stopMaintenanceScheduler() {
+    pid_t pid = readSchedulerPid();
+    if (!pid) {
+        cout << "Maintenance scheduler is not running." << endl;
+        return false;
+    }
+    kill(pid, SIGTERM);
+    cout << "Stopped maintenance scheduler (pid " << pid << ")." << endl;
+    return true;
+}
+#else
+bool startMaintenanceScheduler(const function<vector<string>()>&) {
+    cout << "Background maintenance is not supported on this platform; use `maintenance run`." << endl;
+    return false;
+}
+
+bool stopMaintenanceScheduler() {
+    cout << "Maintenance scheduler is not running." << endl;
+    return false;
+}
+#endif
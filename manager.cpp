@@ -11,6 +11,10 @@
 #include <vector>
 #include <algorithm>
 #include "core.cpp"
+#include "diffstat.cpp"
+#include "extsort.cpp"
+#include "maintenance.cpp"
+#include "migrate.cpp"
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -21,27 +25,6 @@ namespace fs = std::filesystem;
 #define YEL "\x1B[33m"
 #define END "\033[0m"
 
-// =============================================================================
-// FILE COMPARISON UTILITY
-// =============================================================================
-
-/**
- * Performs a binary comparison between two files to check if they are identical.
- */
-bool filesAreSame(const fs::path &a, const fs::path &b) {
-    if (!fs::exists(a) || !fs::exists(b)) return false;
-    if (fs::file_size(a) != fs::file_size(b)) return false;
-
-    ifstream fa(a, ios::binary);
-    ifstream fb(b, ios::binary);
-
-    return equal(
-        istreambuf_iterator<char>(fa),
-        istreambuf_iterator<char>(),
-        istreambuf_iterator<char>(fb)
-    );
-}
-
 // =============================================================================
 // GIT CLASS DEFINITION
 // =============================================================================
@@ -56,12 +39,21 @@ public:
     void gitAdd(string files[], int n);     // git add file1 file2
     bool gitCommit(string msg);
     bool gitRevert(string commitHash);
-    void gitLog();
+    void gitLog(bool stat = false);
     void gitStatus();
+    bool gitCherryPick(string rev);
+    bool gitRebase(string onto);
+    bool gitStashPush(string msg);
+    bool gitStashPop();
+    void gitStashList();
+    void gitReflog();
+    bool gitReset(string mode, string rev);
+    void gitClean(bool dryRun);
+    bool gitReflogAt(string when);
+    bool gitMaintenance(string action, string task, double timeLimit);
+    bool gitShow(string spec);
+    bool gitMigrate();
 
-private:
-    void clearStagingArea();
-    
     /**
      * Helper to check if a path should be ignored by the VCS.
      */
@@ -78,27 +70,37 @@ private:
      * Reads and cleans the current HEAD hash.
      */
     string getHEAD() {
-        ifstream file(".git/HEAD");
-        string head;
-        if (!getline(file, head)) return "NULL";
-        head.erase(remove_if(head.begin(), head.end(), ::isspace), head.end());
+        string head = readHEAD();
         return head.empty() ? "NULL" : head;
     }
+
+private:
+    void clearStagingArea();
+    bool stagingIsEmpty();
+    vector<string> blockedPaths(const commitTree& from, const treeDelta& delta);
+    void applyToWorkingTree(const treeDelta& delta);
+    void removeFromWorkingTree(const string& rel);
+    vector<string> readStashStack();
+    void writeStashStack(const vector<string>& ids);
 };
 
 // =============================================================================
 // COMMAND IMPLEMENTATIONS
 // =============================================================================
 
+// Sizing of the in-memory staged-path filter; larger staging areas only raise
+// its false-positive rate
+const uint64_t STATUS_STAGED_FILTER_KEYS = 1 << 16;
+
 void gitClass::gitInit() {
     try {
         fs::create_directories(".git/staging_area");
         fs::create_directories(".git/commits");
         
-        ofstream headFile(".git/HEAD");
-        headFile << "NULL";
-        headFile.close();
-        
+        // New repositories get checksums on all metadata from the start
+        if (!fs::exists(".git/config")) ofstream(".git/config") << "core.checksums = required\n";
+        metadata().put("HEAD", "NULL");
+
         cout << GRN << "Initialized empty Git repository." << END << endl;
     } catch (const fs::filesystem_error& e) {
         cerr << RED << "Init failed: " << e.what() << END << endl;
@@ -109,30 +111,41 @@ void gitClass::gitAdd() {
     fs::path root = fs::current_path();
     fs::path staging = root / ".git" / "staging_area";
     string head = getHEAD();
-    fs::path committedData = (head != "NULL") ? root / ".git" / "commits" / head / "Data" : fs::path();
+    string committed = (head != "NULL") ? head : "";
+    snapshotBackend store;
+    bloomFilter committedPaths;
+    bool filtered = loadPathFilter(committed, committedPaths);
+    memScope walk(PHASE_WALK, "gitAdd");
 
     for (fs::recursive_directory_iterator it(root); it != fs::recursive_directory_iterator(); ++it) {
-        fs::path rel = fs::relative(it->path(), root);
+        fs::path rel = it->path().lexically_relative(root);
 
         if (isIgnored(rel)) {
             it.disable_recursion_pending();
             continue;
         }
 
-        if (!fs::is_regular_file(*it)) continue;
+        if (!it->is_regular_file()) continue;
 
+        // Paths the filter rules out are new, so there is nothing to compare against
         fs::path stagedFile = staging / rel;
-        fs::path committedFile = (!committedData.empty()) ? committedData / rel : fs::path();
+        bool maybeCommitted = !filtered || committedPaths.possiblyContains(rel.generic_string());
+        fs::path committedFile = maybeCommitted ? store.get(committed, rel.generic_string()) : fs::path();
 
         // Skip if the file matches the last commit exactly
-        if (fs::exists(committedFile) && filesAreSame(it->path(), committedFile)) {
+        bool unchanged;
+        {
+            memScope compare(PHASE_COMPARE, "gitAdd");
+            unchanged = !committedFile.empty() && filesAreSame(it->path(), committedFile);
+        }
+        if (unchanged) {
             // If it was in staging but now matches the commit, remove from staging
             if (fs::exists(stagedFile)) fs::remove(stagedFile);
             continue;
         }
 
-        fs::create_directories(stagedFile.parent_path());
-        fs::copy_file(it->path(), stagedFile, fs::copy_options::overwrite_existing);
+        memScope copy(PHASE_COPY, "gitAdd");
+        stageFile(it->path(), stagedFile);
     }
 }
 
@@ -140,7 +153,10 @@ void gitClass::gitAdd(string files[], int n) {
     fs::path root = fs::current_path();
     fs::path staging = root / ".git" / "staging_area";
     string head = getHEAD();
-    fs::path committedData = (head != "NULL") ? root / ".git" / "commits" / head / "Data" : fs::path();
+    string committed = (head != "NULL") ? head : "";
+    snapshotBackend store;
+    bloomFilter committedPaths;
+    bool filtered = loadPathFilter(committed, committedPaths);
 
     for (int i = 0; i < n; i++) {
         fs::path src = root / files[i];
@@ -153,26 +169,21 @@ void gitClass::gitAdd(string files[], int n) {
 
         fs::path rel = fs::relative(src, root);
         fs::path stagedFile = staging / rel;
-        fs::path committedFile = (!committedData.empty()) ? committedData / rel : fs::path();
+        bool maybeCommitted = !filtered || committedPaths.possiblyContains(rel.generic_string());
+        fs::path committedFile = maybeCommitted ? store.get(committed, rel.generic_string()) : fs::path();
 
-        if (fs::exists(committedFile) && filesAreSame(src, committedFile)) continue;
+        {
+            memScope compare(PHASE_COMPARE, "gitAdd");
+            if (!committedFile.empty() && filesAreSame(src, committedFile)) continue;
+        }
 
-        fs::create_directories(stagedFile.parent_path());
-        fs::copy_file(src, stagedFile, fs::copy_options::overwrite_existing);
+        memScope copy(PHASE_COPY, "gitAdd");
+        stageFile(src, stagedFile);
     }
 }
 
 bool gitClass::gitCommit(string msg) {
-    fs::path staging = fs::current_path() / ".git" / "staging_area";
-    bool empty = true;
-
-    if (fs::exists(staging)) {
-        for (const auto& e : fs::recursive_directory_iterator(staging)) {
-            if (fs::is_regular_file(e)) { empty = false; break; }
-        }
-    }
-
-    if (empty) {
+    if (stagingIsEmpty()) {
         cout << "Nothing to commit, staging area is empty." << endl;
         return false;
     }
@@ -191,57 +202,623 @@ void gitClass::clearStagingArea() {
     }
 }
 
+bool gitClass::stagingIsEmpty() {
+    fs::path staging = fs::current_path() / ".git" / "staging_area";
+    if (fs::exists(staging)) {
+        for (const auto& e : fs::recursive_directory_iterator(staging)) {
+            if (fs::is_regular_file(e)) return false;
+        }
+    }
+    return true;
+}
+
 void gitClass::gitStatus() {
     fs::path root = fs::current_path();
     fs::path staging = root / ".git" / "staging_area";
     string head = getHEAD();
-    fs::path committedData = (head != "NULL") ? root / ".git" / "commits" / head / "Data" : fs::path();
+    string committed = (head != "NULL") ? head : "";
+    snapshotBackend store;
 
-    vector<string> staged, modified, untracked;
+    // Path lists share the "status.memoryLimit" budget; past it they spill sorted runs to disk
+    uint64_t budget = configSize("status.memoryLimit", 0) / 3;
+    externalSorter staged("staged", budget), modified("modified", budget), untracked("untracked", budget);
+    memScope walk(PHASE_WALK, "gitStatus");
+
+    // Bloom filters answer most "is it staged / committed?" lookups without a stat
+    bloomFilter committedPaths, stagedPaths(STATUS_STAGED_FILTER_KEYS);
+    bool filtered = loadPathFilter(committed, committedPaths);
 
     // 1. Scan Staging Area
     if (fs::exists(staging)) {
         for (const auto& e : fs::recursive_directory_iterator(staging)) {
-            if (fs::is_regular_file(e)) staged.push_back(fs::relative(e.path(), staging).string());
+            if (!e.is_regular_file()) continue;
+            fs::path rel = e.path().lexically_relative(staging);
+            staged.add(rel.string());
+            stagedPaths.add(rel.generic_string());
         }
     }
 
     // 2. Scan Working Directory
     for (fs::recursive_directory_iterator it(root); it != fs::recursive_directory_iterator(); ++it) {
-        fs::path rel = fs::relative(it->path(), root);
-        if (isIgnored(rel) || !fs::is_regular_file(*it)) {
+        fs::path rel = it->path().lexically_relative(root);
+        if (isIgnored(rel) || !it->is_regular_file()) {
             if (isIgnored(rel)) it.disable_recursion_pending();
             continue;
         }
 
-        bool inStaging = fs::exists(staging / rel);
-        bool inCommit = (!committedData.empty()) && fs::exists(committedData / rel);
+        string key = rel.generic_string();
+        bool inStaging = false, inCommit = false;
+        if (stagedPaths.possiblyContains(key)) {
+            latencyTimer t(LAT_STAT);
+            inStaging = fs::exists(staging / rel);
+        }
+        if (!committed.empty() && (!filtered || committedPaths.possiblyContains(key))) {
+            latencyTimer t(LAT_STAT);
+            inCommit = store.exists(committed, key);
+        }
 
         if (inCommit && !inStaging) {
-            if (!filesAreSame(it->path(), committedData / rel)) modified.push_back(rel.string());
+            memScope compare(PHASE_COMPARE, "gitStatus");
+            if (!filesAreSame(it->path(), store.get(committed, key))) modified.add(rel.string());
         } else if (!inCommit && !inStaging) {
-            untracked.push_back(rel.string());
+            untracked.add(rel.string());
         }
     }
 
-    // 3. Display Results
+    // 3. Display Results ('\n' rather than endl: one flush at exit instead of one per line)
+    auto print = [](const string& p) { cout << "  " << p << '\n'; };
     if (!staged.empty()) {
-        cout << GRN << "Changes to be committed:" << END << endl;
-        for (const auto& s : staged) cout << "  " << s << endl;
+        cout << GRN << "Changes to be committed:" << END << '\n';
+        staged.forEach(print);
     }
     if (!modified.empty()) {
-        cout << YEL << "\nChanges not staged for commit:" << END << endl;
-        for (const auto& m : modified) cout << "  " << m << endl;
+        cout << YEL << "\nChanges not staged for commit:" << END << '\n';
+        modified.forEach(print);
     }
     if (!untracked.empty()) {
-        cout << RED << "\nUntracked files:" << END << endl;
-        for (const auto& u : untracked) cout << "  " << u << endl;
+        cout << RED << "\nUntracked files:" << END << '\n';
+        untracked.forEach(print);
     }
     if (staged.empty() && modified.empty() && untracked.empty()) {
         cout << "Nothing to commit, working tree clean." << endl;
     }
 }
 
+// =============================================================================
+// HISTORY REWRITING (CHERRY-PICK / REBASE)
+// =============================================================================
+
+/**
+ * Returns the paths in `delta` whose working-tree copy has local changes relative
+ * to snapshot `from`, i.e. the files that applying the delta would clobber.
+ */
+vector<string> gitClass::blockedPaths(const commitTree& from, const treeDelta& delta) {
+    fs::path root = fs::current_path();
+    vector<string> blocked;
+
+    auto check = [&](const string& rel, const fs::path* incoming) {
+        fs::path wt = root / rel;
+        if (!fs::exists(wt)) return;
+        auto known = from.find(rel);
+        if (known != from.end() && filesAreSame(wt, known->second)) return;
+        if (incoming && filesAreSame(wt, *incoming)) return;
+        blocked.push_back(rel);
+    };
+
+    for (const auto& c : delta.changed) check(c.first, &c.second);
+    for (const auto& r : delta.removed) check(r, nullptr);
+    return blocked;
+}
+
+/**
+ * Writes a delta into the working tree, touching only the paths it names.
+ */
+void gitClass::applyToWorkingTree(const treeDelta& delta) {
+    fs::path root = fs::current_path();
+
+    for (const auto& c : delta.changed) restoreFile(c.second, root / c.first);
+
+    for (const auto& r : delta.removed) removeFromWorkingTree(r);
+}
+
+/**
+ * Deletes a working-tree file and prunes the directories it leaves empty.
+ */
+void gitClass::removeFromWorkingTree(const string& rel) {
+    fs::path root = fs::current_path();
+    fs::path wt = root / rel;
+    if (!fs::remove(wt)) return;
+
+    for (fs::path dir = wt.parent_path(); dir != root && fs::is_empty(dir); dir = dir.parent_path()) {
+        fs::remove(dir);
+    }
+}
+
+bool gitClass::gitCherryPick(string rev) {
+    string target = resolveRevision(rev);
+    if (target.empty()) {
+        cout << RED << "Invalid commit: " << rev << END << endl;
+        return false;
+    }
+    if (!stagingIsEmpty()) {
+        cout << RED << "Error: Staging area is not empty. Commit your changes first." << END << endl;
+        return false;
+    }
+
+    string head = readHEAD();
+    commitTree headTree = readTree(head);
+    treeDelta delta;
+    vector<string> conflicts;
+
+    if (!list.planReplay(target, headTree, delta, conflicts)) {
+        cout << RED << "Cherry-pick of " << target << " conflicts with HEAD in:" << END << endl;
+        for (const auto& c : conflicts) cout << "  " << c << endl;
+        return false;
+    }
+    if (delta.empty()) {
+        cout << "Nothing to cherry-pick, changes of " << target << " are already present." << endl;
+        return false;
+    }
+
+    vector<string> blocked = blockedPaths(headTree, delta);
+    if (!blocked.empty()) {
+        cout << RED << "Error: Local changes would be overwritten in:" << END << endl;
+        for (const auto& b : blocked) cout << "  " << b << endl;
+        return false;
+    }
+
+    commitInfo info;
+    readCommitInfo(target, info);
+    string newID = list.addDelta(head, info.msg + " (Cherry-pick of " + target + ")", delta);
+    applyToWorkingTree(delta);
+    writeHEAD(newID, OP_CHERRY_PICK);
+    return true;
+}
+
+bool gitClass::gitRebase(string onto) {
+    string ontoID = resolveRevision(onto);
+    if (ontoID.empty()) {
+        cout << RED << "Invalid commit: " << onto << END << endl;
+        return false;
+    }
+    if (!stagingIsEmpty()) {
+        cout << RED << "Error: Staging area is not empty. Commit your changes first." << END << endl;
+        return false;
+    }
+
+    string head = readHEAD();
+    vector<string> picks = list.commitsSince(head, ontoID);
+    commitInfo info;
+
+    if (head == ontoID || (!picks.empty() && readCommitInfo(picks[0], info) && info.parent == ontoID)) {
+        cout << "Current history is up to date." << endl;
+        return false;
+    }
+
+    // Replay each commit as a delta on an in-memory view of the new tip.
+    // Only changed paths are written, and the working tree is left alone until the end.
+    fs::path commitsRoot = fs::current_path() / ".git" / "commits";
+    snapshotBackend store;
+    commitTree tipTree = store.list(ontoID);
+    string tip = ontoID;
+    vector<string> created;
+
+    auto rollback = [&]() {
+        for (const auto& id : created) fs::remove_all(commitsRoot / id);
+        eraseCommitInfo(created);
+    };
+
+    for (const auto& id : picks) {
+        treeDelta delta;
+        vector<string> conflicts;
+        if (!list.planReplay(id, tipTree, delta, conflicts)) {
+            rollback();
+            cout << RED << "Rebase stopped: " << id << " conflicts in:" << END << endl;
+            for (const auto& c : conflicts) cout << "  " << c << endl;
+            return false;
+        }
+        if (delta.empty()) continue;
+
+        readCommitInfo(id, info);
+        tip = list.addDelta(tip, info.msg, delta);
+        created.push_back(tip);
+
+        for (const auto& c : delta.changed) tipTree[c.first] = store.get(tip, c.first);
+        for (const auto& r : delta.removed) tipTree.erase(r);
+    }
+
+    commitTree headTree = readTree(head);
+    treeDelta worktree = diffTrees(headTree, tipTree);
+    vector<string> blocked = blockedPaths(headTree, worktree);
+    if (!blocked.empty()) {
+        rollback();
+        cout << RED << "Error: Local changes would be overwritten in:" << END << endl;
+        for (const auto& b : blocked) cout << "  " << b << endl;
+        return false;
+    }
+
+    applyToWorkingTree(worktree);
+    writeHEAD(tip, OP_REBASE);
+    cout << GRN << "Rebased " << created.size() << " commit(s) onto " << ontoID << "." << END << endl;
+    return true;
+}
+
+// =============================================================================
+// RESET / CLEAN
+// =============================================================================
+
+bool gitClass::gitReset(string mode, string rev) {
+    string target = resolveRevision(rev);
+    if (target.empty()) {
+        cout << RED << "Invalid commit: " << rev << END << endl;
+        return false;
+    }
+
+    fs::path root = fs::current_path();
+    string head = readHEAD();
+    treeDelta staged = commitNode::stagedChanges();
+
+    thawCommit(target);
+    writeHEAD(target, OP_RESET);
+    if (mode == "--soft") return true;
+
+    clearStagingArea();
+    if (mode != "--hard") return true;
+
+    // Rewrite only the files whose content differs from the target snapshot
+    commitTree targetTree = readTree(target);
+    size_t updated = 0, removed = 0;
+    for (const auto& t : targetTree) {
+        if (filesAreSame(root / t.first, t.second)) continue;
+        restoreFile(t.second, root / t.first);
+        updated++;
+    }
+
+    // Drop files that were tracked or staged but do not exist in the target
+    set<string> gone;
+    for (const auto& h : readTree(head)) gone.insert(h.first);
+    for (const auto& c : staged.changed) gone.insert(c.first);
+    for (const auto& g : gone) {
+        if (targetTree.count(g) || !fs::exists(root / g)) continue;
+        removeFromWorkingTree(g);
+        removed++;
+    }
+
+    cout << "HEAD is now at " << target << " (" << updated << " updated, " << removed << " removed)." << endl;
+    return true;
+}
+
+void gitClass::gitClean(bool dryRun) {
+    fs::path root = fs::current_path();
+    fs::path staging = root / ".git" / "staging_area";
+    commitTree headTree = readTree(readHEAD());
+    vector<string> untracked;
+
+    for (fs::recursive_directory_iterator it(root); it != fs::recursive_directory_iterator(); ++it) {
+        fs::path rel = it->path().lexically_relative(root);
+        if (isIgnored(rel)) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file()) continue;
+
+        string key = rel.generic_string();
+        if (!headTree.count(key) && !fs::exists(staging / rel)) untracked.push_back(key);
+    }
+
+    // Delete after the walk so the iterator never sees a vanished directory
+    for (const auto& u : untracked) {
+        cout << (dryRun ? "Would remove " : "Removing ") << u << endl;
+        if (!dryRun) removeFromWorkingTree(u);
+    }
+}
+
+// =============================================================================
+// STASH
+// Stash entries are commits under .git/commits whose Staged/ and Worktree/
+// folders hold only the files that differed from their parent (HEAD at push time).
+// Working-tree deletions are listed in removed.txt. The stack is the metadata
+// key refs/stash, one ID per line, newest last.
+// =============================================================================
+
+vector<string> gitClass::readStashStack() {
+    vector<string> ids;
+    string stack;
+    metadata().get("refs/stash", stack);
+    istringstream file(stack);
+    string line;
+    while (getline(file, line)) {
+        line = trim(line);
+        if (!line.empty()) ids.push_back(line);
+    }
+    return ids;
+}
+
+void gitClass::writeStashStack(const vector<string>& ids) {
+    ostringstream file;
+    for (const auto& id : ids) file << id << "\n";
+    metadata().put("refs/stash", file.str());
+}
+
+bool gitClass::gitStashPush(string msg) {
+    fs::path root = fs::current_path();
+    fs::path staging = root / ".git" / "staging_area";
+    string head = readHEAD();
+    commitTree headTree = readTree(head);
+    treeDelta staged = commitNode::stagedChanges();
+
+    set<string> stagedPaths;
+    for (const auto& c : staged.changed) stagedPaths.insert(c.first);
+
+    // Working-tree files that are tracked or staged and differ from HEAD
+    vector<string> changed, removed;
+    for (fs::recursive_directory_iterator it(root); it != fs::recursive_directory_iterator(); ++it) {
+        fs::path rel = it->path().lexically_relative(root);
+        if (isIgnored(rel)) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file()) continue;
+
+        string key = rel.generic_string();
+        auto known = headTree.find(key);
+        if (known != headTree.end() ? !filesAreSame(it->path(), known->second) : stagedPaths.count(key) > 0) {
+            changed.push_back(key);
+        }
+    }
+    for (const auto& t : headTree) {
+        if (!fs::exists(root / t.first)) removed.push_back(t.first);
+    }
+
+    if (staged.empty() && changed.empty() && removed.empty()) {
+        cout << "No local changes to save." << endl;
+        return false;
+    }
+
+    // Save only the changed content into a commit that is not on the HEAD chain
+    string id = gen_random(8);
+    fs::path stashPath = root / ".git" / "commits" / id;
+    for (const auto& c : staged.changed) copyVerbatim(c.second, stashPath / "Staged" / c.first);
+    for (const auto& c : changed) stageFile(root / c, stashPath / "Worktree" / c);
+    fs::create_directories(stashPath);
+    {
+        ofstream removedList(stashPath / "removed.txt");
+        for (const auto& r : removed) removedList << r << "\n";
+    }
+    writeCommitInfo({id, head, msg.empty() ? "WIP on " + (head.empty() ? string("NULL") : head) : msg, get_time()});
+
+    // Bring the working tree and staging area back to HEAD
+    for (const auto& c : changed) {
+        auto known = headTree.find(c);
+        if (known != headTree.end()) restoreFile(known->second, root / c);
+        else fs::remove(root / c);
+    }
+    for (const auto& r : removed) restoreFile(headTree[r], root / r);
+    clearStagingArea();
+
+    vector<string> stack = readStashStack();
+    stack.push_back(id);
+    writeStashStack(stack);
+
+    cout << GRN << "Saved working directory and staging area as stash@{0}." << END << endl;
+    return true;
+}
+
+bool gitClass::gitStashPop() {
+    vector<string> stack = readStashStack();
+    if (stack.empty()) {
+        cout << "No stash entries found." << endl;
+        return false;
+    }
+
+    fs::path root = fs::current_path();
+    fs::path stashPath = root / ".git" / "commits" / stack.back();
+    commitInfo info;
+    if (!readCommitInfo(stack.back(), info)) {
+        cout << RED << "Error: Stash entry " << stack.back() << " is missing." << END << endl;
+        return false;
+    }
+
+    // Gather the stashed paths, keyed by where they go back to
+    vector<pair<string, fs::path>> worktree, staged;
+    vector<string> removed;
+    for (auto& part : {make_pair(string("Worktree"), &worktree), make_pair(string("Staged"), &staged)}) {
+        fs::path dir = stashPath / part.first;
+        if (!fs::exists(dir)) continue;
+        for (const auto& e : fs::recursive_directory_iterator(dir)) {
+            if (e.is_regular_file()) part.second->push_back({e.path().lexically_relative(dir).generic_string(), e.path()});
+        }
+    }
+    {
+        ifstream removedList(stashPath / "removed.txt");
+        string line;
+        while (getline(removedList, line)) if (!line.empty()) removed.push_back(line);
+    }
+
+    // Refuse if HEAD moved on those paths or they carry local changes
+    commitTree headTree = readTree(readHEAD());
+    commitTree baseTree = readTree(info.parent);
+    set<string> paths(removed.begin(), removed.end());
+    for (const auto& w : worktree) paths.insert(w.first);
+    for (const auto& st : staged) paths.insert(st.first);
+
+    vector<string> blocked;
+    for (const auto& p : paths) {
+        auto h = headTree.find(p);
+        auto b = baseTree.find(p);
+        bool sameBase = (h == headTree.end()) ? (b == baseTree.end())
+                      : (b != baseTree.end() && storedFilesAreSame(h->second, b->second));
+        bool clean = (h == headTree.end()) ? !fs::exists(root / p) : filesAreSame(root / p, h->second);
+        if (!sameBase || !clean || fs::exists(root / ".git" / "staging_area" / p)) blocked.push_back(p);
+    }
+    if (!blocked.empty()) {
+        cout << RED << "Error: Cannot apply stash, these paths changed since it was saved:" << END << endl;
+        for (const auto& b : blocked) cout << "  " << b << endl;
+        return false;
+    }
+
+    for (const auto& st : staged) copyVerbatim(st.second, root / ".git" / "staging_area" / st.first);
+    for (const auto& w : worktree) restoreFile(w.second, root / w.first);
+    for (const auto& r : removed) fs::remove(root / r);
+
+    fs::remove_all(stashPath);
+    stack.pop_back();
+    writeStashStack(stack);
+
+    cout << GRN << "Restored stash: " << info.msg << END << endl;
+    return true;
+}
+
+void gitClass::gitStashList() {
+    vector<string> stack = readStashStack();
+    for (size_t i = 0; i < stack.size(); i++) {
+        commitInfo info;
+        if (!readCommitInfo(stack[stack.size() - 1 - i], info)) continue;
+        cout << "stash@{" << i << "}: " << info.msg << "  (" << info.time << ")" << endl;
+    }
+}
+
+// =============================================================================
+// REFLOG
+// =============================================================================
+
+void gitClass::gitReflog() {
+    reflog log;
+    uint64_t n = log.size();
+    for (uint64_t i = 0; i < n; i++) {
+        reflog::entry e;
+        if (!log.read(n - 1 - i, e)) break;
+
+        char when[20];
+        strftime(when, sizeof(when), "%Y/%m/%d %H:%M", localtime(&e.time));
+        cout << YEL << e.newID << END << " HEAD@{" << i << "}: " << reflogOpName(e.op)
+             << " (from " << e.oldID << ")  " << when << '\n';
+    }
+}
+
+bool gitClass::gitReflogAt(string when) {
+    time_t t = parse_time(when);
+    if (t == -1) {
+        cout << RED << "Error: Expected a time as \"YYYY/MM/DD HH:MM\"." << END << endl;
+        return false;
+    }
+    string head = reflog().headAt(t);
+    if (head.empty()) {
+        cout << "No reflog entry at or before " << when << "." << endl;
+        return false;
+    }
+    cout << head << endl;
+    return true;
+}
+
+// =============================================================================
+// SHOW
+// =============================================================================
+
+/**
+ * Prints the content of <commit>:<path>. Packed commits are served from the
+ * segment store through the combined index; others from their Data/ tree.
+ */
+bool gitClass::gitShow(string spec) {
+    size_t colon = spec.find(':');
+    if (colon == string::npos) {
+        cout << RED << "Error: Expected <commit>:<path>." << END << endl;
+        return false;
+    }
+    string id = resolveRevision(spec.substr(0, colon));
+    string path = fs::path(spec.substr(colon + 1)).lexically_normal().generic_string();
+    if (id.empty()) {
+        cout << RED << "Invalid commit: " << spec.substr(0, colon) << END << endl;
+        return false;
+    }
+
+    string content;
+    commitManifest manifest;
+    if (readManifest(id, manifest)) {
+        auto m = manifest.find(path);
+        if (m == manifest.end()) {
+            cout << RED << "Path '" << path << "' does not exist in " << id << "." << END << endl;
+            return false;
+        }
+        ifstream loose(looseObjectPath(m->second.hash), ios::binary);
+        if (loose.is_open()) {
+            content.assign(istreambuf_iterator<char>(loose), istreambuf_iterator<char>());
+        } else if (!segmentStore().read(m->second.hash, content)) {
+            cout << RED << "Error: Object " << m->second.hash << " is missing from the object store." << END << endl;
+            return false;
+        }
+    } else {
+        fs::path stored = fs::path(".git") / "commits" / id / "Data" / path;
+        if (!fs::is_regular_file(stored)) {
+            cout << RED << "Path '" << path << "' does not exist in " << id << "." << END << endl;
+            return false;
+        }
+        ifstream in(stored, ios::binary);
+        content.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    largePointer ptr;
+    if (parseLargePointer(content, ptr)) {
+        ifstream in(largeObjectPath(ptr.hash), ios::binary);
+        cout << in.rdbuf();
+    } else {
+        cout.write(content.data(), (streamsize)content.size());
+    }
+    cout.flush();
+    return true;
+}
+
 // Pass-throughs to Core
 bool gitClass::gitRevert(string hash) { return list.revertCommit(hash); }
-void gitClass::gitLog() { list.printCommitList(); }
\ No newline at end of file
+
+void gitClass::gitLog(bool stat) {
+    if (!stat) {
+        list.printCommitList();
+        return;
+    }
+
+    // Compute every commit's stats up front so they run in parallel
+    vector<string> ids = list.history();
+    vector<vector<fileStat>> stats = commitStats(ids);
+    map<string, size_t> position;
+    for (size_t i = 0; i < ids.size(); i++) position[ids[i]] = i;
+
+    list.printCommitList([&](const string& id) {
+        auto it = position.find(id);
+        if (it != position.end()) printCommitStat(stats[it->second]);
+    });
+}
+
+// =============================================================================
+// MAINTENANCE
+// =============================================================================
+
+/**
+ * "run" performs one time-boxed pass (timeLimit <= 0 uses the configured box);
+ * "start"/"stop" control the background scheduler.
+ */
+bool gitClass::gitMaintenance(string action, string task, double timeLimit) {
+    if (!repositoryExists()) {
+        cout << RED << "Error: Not a mygit repository." << END << endl;
+        return false;
+    }
+    auto roots = [this]() { return readStashStack(); };
+
+    if (action == "start") return startMaintenanceScheduler(roots);
+    if (action == "stop") return stopMaintenanceScheduler();
+
+    maintenanceLimits limits = maintenanceLimitsFromConfig();
+    if (timeLimit > 0) limits.seconds = timeLimit;
+    return runMaintenance(task, limits, roots());
+}
+
+/**
+ * Converts legacy full-copy snapshots to packed storage (see migrate.cpp).
+ */
+bool gitClass::gitMigrate() {
+    if (!repositoryExists()) {
+        cout << RED << "Error: Not a mygit repository." << END << endl;
+        return false;
+    }
+    return runMigration();
+}
@@ -0,0 +1,623 @@
+/**
+ * METASTORE.CPP
+ * Purpose: Embedded log-structured key-value store for small metadata: HEAD,
+ * the stash stack and one record per commit. Writes are appended to a log and
+ * applied to an in-memory sorted table; once the log passes a size limit the
+ * table is written out as an immutable sorted run, and runs are merged
+ * geometrically. Opening a repository reads the run list and the log, plus a
+ * run's index on its first lookup, instead of one small file per commit.
+ * Repositories with the older per-file layout are imported on first open.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+#include "crc32c.cpp"
+#include "readahead.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// ON-DISK FORMAT (.git/meta)
+//   runs     Checksummed text: "gen N", then run names, newest first
+//   log      Records written since the last flush, each followed by its u32 CRC32C
+//   run-N    Blocks of up to META_BLOCK_RECORDS sorted records, each block
+//            followed by its u32 CRC32C; then the index (per block: u32 key
+//            length | first key | u64 offset | u32 length) and its u32 CRC32C;
+//            then the footer: u64 index offset | u64 index length | "MYRUN001"
+//   lock     flock: exclusive for writers, shared while a reader loads the list and log
+// A record is u32 key length | u32 value length (META_TOMBSTONE = erased) | key | value.
+// =============================================================================
+
+const uint32_t META_TOMBSTONE = 0xFFFFFFFF;
+const size_t META_BLOCK_RECORDS = 64;
+const uint64_t META_LOG_LIMIT = 256 << 10;      // Log bytes before the table becomes a run
+const uint64_t META_RUN_FACTOR = 4;             // Geometric factor between run sizes
+const char META_RUN_MAGIC[8] = {'M', 'Y', 'R', 'U', 'N', '0', '0', '1'};
+const size_t META_FOOTER_LEN = 2 * sizeof(uint64_t) + sizeof(META_RUN_MAGIC);
+
+// Sorted key -> value; an empty optional is a tombstone that hides older runs
+typedef map<string, optional<string>> metaTable;
+
+fs::path metaDir() {
+    return fs::path(".git") / "meta";
+}
+
+/**
+ * True inside a repository in either metadata layout.
+ */
+bool repositoryExists() {
+    return fs::exists(metaDir()) || fs::exists(fs::path(".git") / "HEAD");
+}
+
+void appendRecord(string& out, const string& key, const optional<string>& value) {
+    uint32_t klen = (uint32_t)key.size();
+    uint32_t vlen = value ? (uint32_t)value->size() : META_TOMBSTONE;
+    out.append(reinterpret_cast<const char*>(&klen), sizeof(klen));
+    out.append(reinterpret_cast<const char*>(&vlen), sizeof(vlen));
+    out += key;
+    if (value) out += *value;
+}
+
+/**
+ * Decodes the record at `pos` (advancing it). Returns false if it would run past `end`.
+ */
+bool parseRecord(const string& buf, size_t& pos, size_t end, string& key, optional<string>& value) {
+    uint32_t klen, vlen;
+    if (end - pos < 2 * sizeof(uint32_t)) return false;
+    memcpy(&klen, buf.data() + pos, sizeof(klen));
+    memcpy(&vlen, buf.data() + pos + sizeof(klen), sizeof(vlen));
+    size_t need = 2 * sizeof(uint32_t) + klen + (vlen == META_TOMBSTONE ? 0 : vlen);
+    if (end - pos < need) return false;
+
+    key.assign(buf, pos + 2 * sizeof(uint32_t), klen);
+    if (vlen == META_TOMBSTONE) value.reset();
+    else value = buf.substr(pos + 2 * sizeof(uint32_t) + klen, vlen);
+    pos += need;
+    return true;
+}
+
+bool readBytes(ifstream& in, uint64_t offset, uint64_t length, string& out) {
+    out.resize(length);
+    in.clear();
+    in.seekg((streamoff)offset);
+    return (bool)in.read(&out[0], (streamsize)length) || length == 0;
+}
+
+// =============================================================================
+// SORTED RUNS
+// =============================================================================
+
+class metaRunWriter {
+private:
+    fs::path path;
+    ofstream out;
+    uint64_t written = 0;
+    string block, firstKey, index;
+    size_t records = 0;
+
+    void endBlock() {
+        if (records == 0) return;
+        uint32_t crc = crc32c(block.data(), block.size());
+        block.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+        out.write(block.data(), (streamsize)block.size());
+
+        uint32_t klen = (uint32_t)firstKey.size(), length = (uint32_t)block.size();
+        index.append(reinterpret_cast<const char*>(&klen), sizeof(klen));
+        index += firstKey;
+        index.append(reinterpret_cast<const char*>(&written), sizeof(written));
+        index.append(reinterpret_cast<const char*>(&length), sizeof(length));
+
+        written += block.size();
+        block.clear();
+        records = 0;
+    }
+
+public:
+    explicit metaRunWriter(const fs::path& p) : path(p) {
+        out.open(p, ios::binary | ios::trunc);
+    }
+
+    // Keys must arrive in ascending order
+    void add(const string& key, const optional<string>& value) {
+        if (records == 0) firstKey = key;
+        appendRecord(block, key, value);
+        if (++records == META_BLOCK_RECORDS) endBlock();
+    }
+
+    bool finish() {
+        endBlock();
+        uint64_t indexOffset = written, indexLength = index.size();
+        uint32_t crc = crc32c(index.data(), index.size());
+        out.write(index.data(), (streamsize)index.size());
+        out.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+        out.write(reinterpret_cast<const char*>(&indexOffset), sizeof(indexOffset));
+        out.write(reinterpret_cast<const char*>(&indexLength), sizeof(indexLength));
+        out.write(META_RUN_MAGIC, sizeof(META_RUN_MAGIC));
+        out.close();
+        return !out.fail();
+    }
+};
+
+/**
+ * A run kept open from the moment the list naming it was read, so a
+ * concurrent compaction deleting the file cannot pull it away mid-command.
+ * Lookups may come from worker threads (log --stat), so the shared stream
+ * and the lazily loaded index are guarded by a mutex.
+ */
+class metaRun {
+private:
+    struct blockRef {
+        string first;
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    fs::path path;
+    mutable ifstream in;
+    uint64_t bytes = 0;
+    mutable vector<blockRef> index;
+    mutable bool indexed = false;
+    mutable mutex m;
+
+    void loadIndex() const {
+        lock_guard<mutex> lock(m);
+        if (indexed) return;
+        string footer, raw;
+        uint64_t indexOffset, indexLength;
+        if (bytes < META_FOOTER_LEN || !readBytes(in, bytes - META_FOOTER_LEN, META_FOOTER_LEN, footer) ||
+            memcmp(footer.data() + 16, META_RUN_MAGIC, sizeof(META_RUN_MAGIC)) != 0) checksumFailure(path);
+        memcpy(&indexOffset, footer.data(), sizeof(indexOffset));
+        memcpy(&indexLength, footer.data() + 8, sizeof(indexLength));
+        if (indexOffset + indexLength + sizeof(uint32_t) + META_FOOTER_LEN != bytes ||
+            !readBytes(in, indexOffset, indexLength + sizeof(uint32_t), raw)) checksumFailure(path);
+
+        uint32_t crc;
+        memcpy(&crc, raw.data() + indexLength, sizeof(crc));
+        if (crc32c(raw.data(), indexLength) != crc) checksumFailure(path);
+
+        for (size_t pos = 0; pos < indexLength;) {
+            blockRef b;
+            uint32_t klen;
+            if (indexLength - pos < sizeof(klen)) checksumFailure(path);
+            memcpy(&klen, raw.data() + pos, sizeof(klen));
+            pos += sizeof(klen);
+            if (indexLength - pos < klen + sizeof(b.offset) + sizeof(b.length)) checksumFailure(path);
+            b.first = raw.substr(pos, klen);
+            pos += klen;
+            memcpy(&b.offset, raw.data() + pos, sizeof(b.offset));
+            memcpy(&b.length, raw.data() + pos + sizeof(b.offset), sizeof(b.length));
+            pos += sizeof(b.offset) + sizeof(b.length);
+            index.push_back(b);
+        }
+        indexed = true;
+    }
+
+public:
+    explicit metaRun(const fs::path& p) : path(p), in(p, ios::binary) {
+        error_code ec;
+        bytes = fs::file_size(p, ec);
+        if (!in.is_open() || ec) checksumFailure(p);
+    }
+
+    const fs::path& file() const { return path; }
+    uint64_t size() const { return bytes; }
+
+    size_t blocks() const {
+        loadIndex();
+        return index.size();
+    }
+
+    /**
+     * Loads block `i` without its CRC (exits if the CRC does not match).
+     */
+    string block(size_t i) const {
+        loadIndex();
+        string data;
+        const blockRef& b = index[i];
+        bool read;
+        {
+            lock_guard<mutex> lock(m);
+            read = b.length >= sizeof(uint32_t) && readBytes(in, b.offset, b.length, data);
+        }
+        if (!read) checksumFailure(path);
+        uint32_t crc;
+        size_t payload = b.length - sizeof(crc);
+        memcpy(&crc, data.data() + payload, sizeof(crc));
+        if (crc32c(data.data(), payload) != crc) checksumFailure(path);
+        data.resize(payload);
+        return data;
+    }
+
+    /**
+     * True if the run holds `key` (`value` is empty for a tombstone).
+     */
+    bool find(const string& key, optional<string>& value) const {
+        loadIndex();
+        auto it = upper_bound(index.begin(), index.end(), key,
+                              [](const string& k, const blockRef& b) { return k < b.first; });
+        if (it == index.begin()) return false;
+
+        string data = block((size_t)(it - index.begin()) - 1);
+        string k;
+        for (size_t pos = 0; pos < data.size();) {
+            if (!parseRecord(data, pos, data.size(), k, value)) checksumFailure(path);
+            if (k == key) return true;
+            if (k > key) return false;
+        }
+        return false;
+    }
+};
+
+/**
+ * Walks a run's records in key order, one block in memory at a time.
+ */
+class metaRunCursor {
+private:
+    const metaRun& run;
+    size_t nextBlock = 0;
+    string data;
+    size_t pos = 0;
+
+public:
+    string key;
+    optional<string> value;
+    bool valid = false;
+
+    explicit metaRunCursor(const metaRun& r) : run(r) { next(); }
+
+    void next() {
+        while (pos >= data.size()) {
+            if (nextBlock >= run.blocks()) {
+                valid = false;
+                return;
+            }
+            data = run.block(nextBlock++);
+            pos = 0;
+        }
+        if (!parseRecord(data, pos, data.size(), key, value)) checksumFailure(run.file());
+        valid = true;
+    }
+};
+
+// =============================================================================
+// STORE
+// =============================================================================
+
+#ifndef _WIN32
+class metaLock {
+private:
+    int fd = -1;
+
+public:
+    metaLock(bool exclusive) {
+        fd = open((metaDir() / "lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd >= 0) flock(fd, exclusive ? LOCK_EX : LOCK_SH);
+    }
+    ~metaLock() { if (fd >= 0) close(fd); }
+};
+#else
+class metaLock {
+public:
+    metaLock(bool) {}
+};
+#endif
+
+class metaStore {
+private:
+    uint64_t gen = 0;
+    vector<unique_ptr<metaRun>> runs;   // Newest first
+    metaTable table;                    // Contents of the log
+    uint64_t logBytes = 0;              // Length of the log's valid prefix
+
+    fs::path logPath() const { return metaDir() / "log"; }
+
+    static uint64_t readList(vector<string>& names) {
+        string list;
+        if (!readSealedText(metaDir() / "runs", list)) return 0;
+        istringstream in(list);
+        string tag, name;
+        uint64_t g = 0;
+        in >> tag >> g;
+        while (in >> name) names.push_back(name);
+        return g;
+    }
+
+    void saveList() {
+        ostringstream out;
+        out << "gen " << gen << "\n";
+        for (const auto& r : runs) out << r->file().filename().string() << "\n";
+        if (!writeSealedText(metaDir() / "runs", out.str(), true)) throw runtime_error("File Access Error");
+    }
+
+    /**
+     * Applies log records from `logBytes` on. A record cut short by a crash
+     * ends the valid prefix.
+     */
+    void replayLog() {
+        ifstream in(logPath(), ios::binary);
+        if (!in.is_open()) return;
+        in.seekg((streamoff)logBytes);
+        string buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+        string key;
+        optional<string> value;
+        for (size_t pos = 0; pos < buf.size();) {
+            size_t start = pos;
+            uint32_t crc;
+            if (!parseRecord(buf, pos, buf.size(), key, value) || buf.size() - pos < sizeof(crc)) break;
+            memcpy(&crc, buf.data() + pos, sizeof(crc));
+            if (crc32c(buf.data() + start, pos - start) != crc) break;
+            pos += sizeof(crc);
+            table[key] = value;
+            logBytes += pos - start;
+        }
+    }
+
+    void load() {
+        vector<string> names;
+        gen = readList(names);
+        runs.clear();
+        for (const auto& n : names) runs.emplace_back(new metaRun(metaDir() / n));
+        table.clear();
+        logBytes = 0;
+        replayLog();
+    }
+
+    /**
+     * Catches up with other processes' writes; callers hold the exclusive lock.
+     * A torn tail left by a crashed writer is cut off so appends follow valid records.
+     */
+    void sync() {
+        vector<string> names;
+        if (readList(names) != gen) load();
+        else replayLog();
+
+        error_code ec;
+        if (fs::exists(logPath(), ec) && fs::file_size(logPath(), ec) > logBytes) fs::resize_file(logPath(), logBytes, ec);
+    }
+
+    string nextRunName() {
+        char name[32];
+        snprintf(name, sizeof(name), "run-%016llu", (unsigned long long)++gen);
+        return name;
+    }
+
+    /**
+     * Writes a sorted run under a temporary name and renames it into place.
+     * The run is on disk before saveList() names it, and the files it
+     * replaces are deleted only after that.
+     */
+    fs::path writeRun(const function<void(metaRunWriter&)>& fill) {
+        fs::path p = metaDir() / nextRunName();
+        fs::path tmp = p;
+        tmp += ".tmp";
+        metaRunWriter w(tmp);
+        fill(w);
+        if (!w.finish() || !syncPath(tmp)) throw runtime_error("File Access Error");
+        fs::rename(tmp, p);
+        if (!syncPath(metaDir())) throw runtime_error("File Access Error");
+        return p;
+    }
+
+    /**
+     * Turns the table into the newest run and starts an empty log.
+     */
+    void flush() {
+        if (table.empty()) return;
+        fs::path p = writeRun([&](metaRunWriter& w) {
+            for (const auto& t : table) w.add(t.first, t.second);
+        });
+        runs.emplace(runs.begin(), new metaRun(p));
+        saveList();
+        fs::remove(logPath());
+        table.clear();
+        logBytes = 0;
+    }
+
+    /**
+     * Keeps every run at least META_RUN_FACTOR times larger than all newer
+     * runs combined by merging the newest runs that violate it. Tombstones
+     * are dropped once the merge reaches the oldest run.
+     */
+    void compact() {
+        if (runs.size() < 2) return;
+        size_t last = 0;
+        uint64_t rolled = runs[0]->size();
+        while (last + 1 < runs.size() && runs[last + 1]->size() < META_RUN_FACTOR * rolled) {
+            last++;
+            rolled += runs[last]->size();
+        }
+        if (last == 0) return;
+        bool oldest = (last + 1 == runs.size());
+
+        fs::path p = writeRun([&](metaRunWriter& w) {
+            vector<unique_ptr<metaRunCursor>> cursors;
+            for (size_t i = 0; i <= last; i++) cursors.emplace_back(new metaRunCursor(*runs[i]));
+            while (true) {
+                // The smallest key wins; among equal keys the newest run (lowest index) does
+                int pick = -1;
+                for (size_t i = 0; i < cursors.size(); i++) {
+                    if (cursors[i]->valid && (pick < 0 || cursors[i]->key < cursors[pick]->key)) pick = (int)i;
+                }
+                if (pick < 0) break;
+                string key = cursors[pick]->key;
+                if (cursors[pick]->value || !oldest) w.add(key, cursors[pick]->value);
+                for (auto& c : cursors) {
+                    if (c->valid && c->key == key) c->next();
+                }
+            }
+        });
+
+        vector<fs::path> merged;
+        for (size_t i = 0; i <= last; i++) merged.push_back(runs[i]->file());
+        runs.erase(runs.begin(), runs.begin() + (ptrdiff_t)last + 1);
+        runs.emplace(runs.begin(), new metaRun(p));
+        saveList();
+        error_code ec;
+        for (const auto& m : merged) fs::remove(m, ec);
+    }
+
+    /**
+     * Moves HEAD, the stash stack and every commitInfo.txt of a repository
+     * in the per-file layout into one run, then deletes the old files.
+     */
+    void importLegacy() {
+        fs::create_directories(metaDir());
+        metaLock lock(true);
+        if (fs::exists(metaDir() / "runs") || !fs::exists(fs::path(".git") / "HEAD")) return;
+
+        metaTable imported;
+        vector<fs::path> legacy;
+        string body;
+        if (readSealedText(fs::path(".git") / "HEAD", body)) {
+            body = body.substr(0, body.find('\n'));
+            body.erase(body.find_last_not_of(" \t\r") + 1);
+            imported["HEAD"] = body;
+        }
+        ifstream stash(fs::path(".git") / "stash", ios::binary);
+        if (stash.is_open()) {
+            imported["refs/stash"] = string((istreambuf_iterator<char>(stash)), istreambuf_iterator<char>());
+            legacy.push_back(fs::path(".git") / "stash");
+        }
+        error_code ec;
+        for (const auto& e : fs::directory_iterator(fs::path(".git") / "commits", ec)) {
+            fs::path info = e.path() / "commitInfo.txt";
+            if (!readSealedText(info, body)) continue;
+            imported["commit/" + e.path().filename().string()] = body;
+            legacy.push_back(info);
+        }
+
+        fs::path p = writeRun([&](metaRunWriter& w) {
+            for (const auto& t : imported) w.add(t.first, t.second);
+        });
+        runs.clear();
+        runs.emplace_back(new metaRun(p));
+        saveList();
+
+        // The run and the list naming it are synced, so the old files can go; HEAD goes
+        // first so the repository never looks half-migrated
+        fs::remove(fs::path(".git") / "HEAD", ec);
+        for (const auto& l : legacy) fs::remove(l, ec);
+    }
+
+public:
+    metaStore() {
+        if (!fs::exists(metaDir() / "runs") && fs::exists(fs::path(".git") / "HEAD")) importLegacy();
+        if (!fs::exists(metaDir())) return;
+        metaLock lock(false);
+        load();
+    }
+
+    metaStore(const metaStore&) = delete;
+    metaStore& operator=(const metaStore&) = delete;
+
+    bool get(const string& key, string& value) const {
+        auto t = table.find(key);
+        if (t != table.end()) {
+            if (t->second) value = *t->second;
+            return t->second.has_value();
+        }
+        for (const auto& r : runs) {
+            optional<string> found;
+            if (!r->find(key, found)) continue;
+            if (found) value = *found;
+            return found.has_value();
+        }
+        return false;
+    }
+
+    /**
+     * Appends a batch of changes (empty optional = erase) to the log as one
+     * write, then flushes and compacts if the log has grown past its limit.
+     */
+    void apply(const metaTable& changes) {
+        update([&]() { return changes; });
+    }
+
+    /**
+     * Like apply(), but the batch comes from `decide`, which runs under the
+     * write lock after other processes' writes are picked up. No one can move
+     * HEAD or change the stash stack until the batch is written, so `decide`
+     * may act on what it reads (it must not call apply() itself).
+     */
+    void update(const function<metaTable()>& decide) {
+        if (!fs::exists(".git")) throw runtime_error("File Access Error");
+        fs::create_directories(metaDir());
+        metaLock lock(true);
+        sync();
+
+        metaTable changes = decide();
+        if (changes.empty()) return;
+        string buf;
+        for (const auto& c : changes) {
+            size_t start = buf.size();
+            appendRecord(buf, c.first, c.second);
+            uint32_t crc = crc32c(buf.data() + start, buf.size() - start);
+            buf.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+        }
+        {
+            ofstream out(logPath(), ios::binary | ios::app);
+            out.write(buf.data(), (streamsize)buf.size());
+            if (!out) throw runtime_error("File Access Error");
+        }
+        for (const auto& c : changes) table[c.first] = c.second;
+        logBytes += buf.size();
+
+        if (logBytes > META_LOG_LIMIT) {
+            flush();
+            compact();
+        }
+    }
+
+    /**
+     * Picks up writes other processes made since the store was opened
+     * (long-running processes call this before each pass).
+     */
+    void refresh() {
+        if (!fs::exists(metaDir())) return;
+        metaLock lock(false);
+        vector<string> names;
+        if (readList(names) != gen) load();
+        else replayLog();
+    }
+
+    void put(const string& key, const string& value) { apply({{key, value}}); }
+    void erase(const string& key) { apply({{key, nullopt}}); }
+
+    /**
+     * Starts reading every run, for callers about to look up many keys
+     * (history walks visit commit records in no particular key order).
+     */
+    void willNeedAll() const {
+        for (const auto& r : runs) adviseWillNeed(r->file());
+    }
+};
+
+/**
+ * The repository's metadata store, opened on first use.
+ */
+metaStore& metadata() {
+    static metaStore store;
+    return store;
+}
@@ -0,0 +1,199 @@
+/**
+ * MIGRATE.CPP
+ * Purpose: One-shot conversion of repositories written in the legacy layout
+ * (a full copy of every file under .git/commits/<id>/Data) to packed storage.
+ * Files are hashed in parallel and each distinct content is stored once in the
+ * segment store; old snapshots are then archived by the usual policy, and the
+ * snapshots that stay loose share one hard-linked copy per content. Every step
+ * is idempotent, so an interrupted migration simply resumes.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <limits>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// Commits per segment: bounds memory and is the unit of resumable progress
+const size_t MIGRATE_BATCH_COMMITS = 64;
+
+fs::path migrateStartPath() {
+    return maintenanceDir() / "migrate.start";
+}
+
+/**
+ * Bytes used by commit snapshots and segments, counting hard-linked files once.
+ */
+uintmax_t storageBytes() {
+    uintmax_t total = 0;
+#ifndef _WIN32
+    set<pair<dev_t, ino_t>> seen;
+#endif
+    for (const char* sub : {"commits", "objects"}) {
+        error_code ec;
+        for (const auto& e : fs::recursive_directory_iterator(fs::path(".git") / sub, ec)) {
+            if (!e.is_regular_file(ec)) continue;
+#ifndef _WIN32
+            struct stat st;
+            if (stat(e.path().c_str(), &st) == 0 && !seen.insert({st.st_dev, st.st_ino}).second) continue;
+#endif
+            total += e.file_size(ec);
+        }
+    }
+    return total;
+}
+
+string formatBytes(uintmax_t bytes) {
+    const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+    double v = (double)bytes;
+    int u = 0;
+    while (v >= 1024 && u < 4) { v /= 1024; u++; }
+    char buf[32];
+    snprintf(buf, sizeof(buf), u ? "%.1f %s" : "%.0f %s", v, units[u]);
+    return buf;
+}
+
+/**
+ * Hashes every file of a batch of commits on worker threads, writes the
+ * distinct contents into one new segment and then the commits' manifests.
+ * Returns the number of files processed.
+ */
+size_t packBatch(segmentStore& store, const vector<string>& ids) {
+    struct job {
+        size_t commit;
+        string rel;
+        fs::path path;
+        manifestEntry entry;
+    };
+    vector<job> jobs;
+    for (size_t c = 0; c < ids.size(); c++) {
+        for (const auto& t : readTree(ids[c])) jobs.push_back({c, t.first, t.second, {}});
+    }
+
+    // Workers take files in list order, so readahead can run a window in front of them
+    vector<fs::path> files;
+    for (const auto& j : jobs) files.push_back(j.path);
+    prefetcher ahead(move(files), PREFETCH_DATA, PREFETCH_WINDOW * workerThreads());
+
+    atomic<size_t> next(0);
+    vector<thread> workers;
+    for (unsigned t = 0; t < min<size_t>(workerThreads(), jobs.size()); t++) {
+        workers.emplace_back([&]() {
+            for (size_t j = next++; j < jobs.size(); j = next++) {
+                ahead.consumed(j);
+                error_code ec;
+                jobs[j].entry = {hashFile(jobs[j].path), fs::file_size(jobs[j].path, ec)};
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    // One pack file, so content is appended sequentially
+    segmentWriter writer = store.beginSegment();
+    vector<commitManifest> manifests(ids.size());
+    for (const auto& j : jobs) {
+        if (!writer.has(j.entry.hash) && !store.contains(j.entry.hash)) writer.addFile(j.entry.hash, j.path);
+        manifests[j.commit][j.rel] = j.entry;
+    }
+    store.addSegment(writer);
+    for (size_t c = 0; c < ids.size(); c++) writeManifest(ids[c], manifests[c]);
+    return jobs.size();
+}
+
+/**
+ * Hard-links every file of the loose snapshots to the first stored copy of
+ * the same content, across all commits. Returns the number of files linked.
+ */
+size_t linkDuplicates() {
+    fs::path commitsRoot = fs::path(".git") / "commits";
+    map<string, fs::path> canonical;
+    size_t linked = 0;
+
+    for (const auto& id : allCommitIDs()) {
+        fs::path data = commitsRoot / id / "Data";
+        commitManifest manifest;
+        if (!fs::exists(data) || !readManifest(id, manifest)) continue;
+
+        for (const auto& m : manifest) {
+            fs::path file = data / m.first;
+            auto it = canonical.insert({m.second.hash, file}).first;
+            error_code ec;
+            if (it->second == file || fs::equivalent(it->second, file, ec)) continue;
+            if (fs::file_size(file, ec) == m.second.size && linkInPlace(it->second, file)) linked++;
+        }
+    }
+    return linked;
+}
+
+/**
+ * Converts every commit still in the legacy layout and reports the space
+ * saved since the migration first started.
+ */
+bool runMigration() {
+    maintenanceLock lock;
+    if (!lock.held()) {
+        cout << "A maintenance run is in progress; try again when it finishes." << endl;
+        return false;
+    }
+
+    // The starting size survives interruptions so the report covers the whole migration
+    uintmax_t before = 0;
+    if (!(ifstream(migrateStartPath()) >> before)) {
+        before = storageBytes();
+        fs::create_directories(maintenanceDir());
+        ofstream(migrateStartPath(), ios::trunc) << before << "\n";
+    }
+
+    // 1. PACK: commits without a manifest, in batches of one segment each
+    vector<string> pending;
+    fs::path commitsRoot = fs::path(".git") / "commits";
+    for (const auto& id : allCommitIDs()) {
+        if (fs::exists(commitsRoot / id / "Data") && !fs::exists(manifestPath(id))) pending.push_back(id);
+    }
+
+    segmentStore store;
+    store.refreshIndex();
+    size_t files = 0;
+    for (size_t i = 0; i < pending.size(); i += MIGRATE_BATCH_COMMITS) {
+        vector<string> batch(pending.begin() + i, pending.begin() + min(pending.size(), i + MIGRATE_BATCH_COMMITS));
+        files += packBatch(store, batch);
+        store.compactGeometric(segmentFactor());
+        cout << "\rPacked " << i + batch.size() << "/" << pending.size() << " commit(s)" << flush;
+    }
+    if (!pending.empty()) cout << '\n';
+
+    // 2. ARCHIVE: old snapshots leave the loose layout (archive.afterCommits / afterDays)
+    maintenanceLimits unlimited;
+    unlimited.seconds = numeric_limits<double>::infinity();
+    maintenanceBudget budget(unlimited);
+    bool finished = false;
+    size_t archived = archiveHistory(budget, {}, finished);
+
+    // 3. LINK: loose snapshots keep one copy per distinct content
+    size_t linked = linkDuplicates();
+
+    uintmax_t after = storageBytes();
+    fs::remove(migrateStartPath());
+
+    cout << "Migrated " << pending.size() << " commit(s) (" << files << " file(s)): "
+         << archived << " archived, " << linked << " duplicate file(s) linked." << '\n';
+    cout << "Storage: " << formatBytes(before) << " -> " << formatBytes(after);
+    if (after <= before) {
+        cout << " (saved " << formatBytes(before - after);
+        if (before) cout << ", " << (int)(100.0 * (before - after) / before) << "%";
+        cout << ")";
+    }
+    cout << endl;
+    return true;
+}
@@ -0,0 +1,125 @@
+/**
+ * READAHEAD.CPP
+ * Purpose: Access-pattern hints for history-wide scans. When the files a scan
+ * will read are known in advance, a helper thread opens them a little ahead
+ * of the consumer and asks the kernel to start reading (posix_fadvise
+ * WILLNEED), so cold-storage I/O overlaps with the work instead of stalling
+ * it one file at a time. Hints are best effort and a no-op on Windows.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// Short lists are not worth a thread: the consumer reaches them immediately
+const size_t PREFETCH_MIN_FILES = 32;
+
+// Default distance, in files, a bounded prefetcher runs ahead of its consumer
+const size_t PREFETCH_WINDOW = 64;
+
+enum prefetchMode {
+    PREFETCH_DATA,      // Content will be read
+    PREFETCH_INODE,     // Only metadata is needed (stat, hard link)
+};
+
+/**
+ * Starts asynchronous readahead of a file's content (the whole file when
+ * `length` is 0) and returns without waiting for it.
+ */
+void adviseWillNeed(const fs::path& p, off_t offset = 0, off_t length = 0) {
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED);
+    close(fd);
+#else
+    (void)p; (void)offset; (void)length;
+#endif
+}
+
+void prefetchOne(const fs::path& p, prefetchMode mode) {
+#ifndef _WIN32
+    if (mode == PREFETCH_INODE) {
+        struct stat st;
+        stat(p.c_str(), &st);
+        return;
+    }
+#endif
+    adviseWillNeed(p);
+}
+
+/**
+ * Hints a list of files, in order, on a helper thread. With a `window`, the
+ * helper stays at most that many files ahead of the position reported
+ * through consumed(), so a long scan does not flush the page cache; with no
+ * window it runs through the whole list. Stops when destroyed.
+ */
+class prefetcher {
+private:
+    vector<fs::path> paths;
+    prefetchMode mode;
+    size_t window;
+    size_t done = 0;
+    bool stopping = false;
+    mutex m;
+    condition_variable cv;
+    thread worker;
+
+    void run() {
+        for (size_t i = 0; i < paths.size(); i++) {
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&]() { return stopping || !window || i < done + window; });
+                if (stopping) return;
+            }
+            prefetchOne(paths[i], mode);
+        }
+    }
+
+public:
+    prefetcher(vector<fs::path> files, prefetchMode kind = PREFETCH_DATA, size_t ahead = 0)
+        : paths(move(files)), mode(kind), window(ahead) {
+#ifndef _WIN32
+        if (paths.size() >= PREFETCH_MIN_FILES) worker = thread([this]() { run(); });
+#endif
+    }
+
+    prefetcher(const prefetcher&) = delete;
+    prefetcher& operator=(const prefetcher&) = delete;
+
+    /**
+     * Reports that the consumer has finished with the first `n` files
+     * (parallel consumers may report out of order; the furthest wins).
+     */
+    void consumed(size_t n) {
+        if (!window || !worker.joinable()) return;
+        {
+            lock_guard<mutex> lock(m);
+            done = max(done, n);
+        }
+        cv.notify_one();
+    }
+
+    ~prefetcher() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+};
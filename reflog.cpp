@@ -0,0 +1,205 @@
+/**
+ * REFLOG.CPP
+ * Purpose: Append-only binary journal of every HEAD move, with a sparse
+ * time index so "where was HEAD at time T" is a binary search, not a scan.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// ON-DISK FORMAT
+// .git/logs/HEAD.bin : fixed-size reflogRecord entries, oldest first
+// .git/logs/HEAD.idx : one reflogCheckpoint per REFLOG_STRIDE records
+// Timestamps are clamped to be non-decreasing so both files stay sorted by time.
+// =============================================================================
+
+const uint64_t REFLOG_STRIDE = 64;
+
+enum reflogOp : uint8_t {
+    OP_COMMIT = 1,
+    OP_REVERT,
+    OP_CHERRY_PICK,
+    OP_REBASE,
+    OP_RESET,
+};
+
+struct reflogRecord {
+    char oldID[16];
+    char newID[16];
+    int64_t time;
+    uint8_t op;
+    uint8_t pad[7];
+};
+
+struct reflogCheckpoint {
+    int64_t time;
+    uint64_t record;
+};
+
+static_assert(sizeof(reflogRecord) == 48, "reflog record layout must stay fixed");
+
+const char* reflogOpName(uint8_t op) {
+    switch (op) {
+        case OP_COMMIT:      return "commit";
+        case OP_REVERT:      return "revert";
+        case OP_CHERRY_PICK: return "cherry-pick";
+        case OP_REBASE:      return "rebase";
+        case OP_RESET:       return "reset";
+    }
+    return "unknown";
+}
+
+// =============================================================================
+// REFLOG CLASS
+// =============================================================================
+
+class reflog {
+private:
+    fs::path journalPath = fs::path(".git") / "logs" / "HEAD.bin";
+    fs::path indexPath = fs::path(".git") / "logs" / "HEAD.idx";
+
+    static string field(const char (&id)[16]) {
+        return string(id, strnlen(id, sizeof(id)));
+    }
+
+    static void trimTornTail(const fs::path& p, uintmax_t recordSize) {
+        error_code ec;
+        uintmax_t size = fs::file_size(p, ec);
+        if (!ec && size % recordSize != 0) fs::resize_file(p, size - size % recordSize, ec);
+    }
+
+    uint64_t count() const {
+        error_code ec;
+        uintmax_t size = fs::file_size(journalPath, ec);
+        return ec ? 0 : size / sizeof(reflogRecord);
+    }
+
+    vector<reflogCheckpoint> loadIndex() {
+        vector<reflogCheckpoint> index;
+        ifstream in(indexPath, ios::binary);
+        reflogCheckpoint cp;
+        while (in.read(reinterpret_cast<char*>(&cp), sizeof(cp))) index.push_back(cp);
+
+        // A crash between the journal and index appends leaves the index short; rebuild it
+        uint64_t expected = (count() + REFLOG_STRIDE - 1) / REFLOG_STRIDE;
+        if (index.size() != expected) {
+            index.clear();
+            ofstream out(indexPath, ios::binary | ios::trunc);
+            for (uint64_t n = 0; n < count(); n += REFLOG_STRIDE) {
+                reflogRecord rec;
+                if (!read(n, rec)) break;
+                cp = {rec.time, n};
+                out.write(reinterpret_cast<const char*>(&cp), sizeof(cp));
+                index.push_back(cp);
+            }
+        }
+        return index;
+    }
+
+public:
+    struct entry {
+        string oldID;
+        string newID;
+        time_t time;
+        uint8_t op;
+    };
+
+    /**
+     * Reads record `n` (0 = oldest).
+     */
+    bool read(uint64_t n, reflogRecord& rec) const {
+        ifstream in(journalPath, ios::binary);
+        in.seekg(n * sizeof(reflogRecord));
+        return bool(in.read(reinterpret_cast<char*>(&rec), sizeof(rec)));
+    }
+
+    bool read(uint64_t n, entry& e) const {
+        reflogRecord rec;
+        if (!read(n, rec)) return false;
+        e = {field(rec.oldID), field(rec.newID), (time_t)rec.time, rec.op};
+        return true;
+    }
+
+    uint64_t size() const { return count(); }
+
+    /**
+     * Appends one HEAD move. Never rewrites existing records, but a partial
+     * record left by a crashed append is cut off first, so the new one lands
+     * on a record boundary.
+     */
+    void append(const string& oldID, const string& newID, reflogOp op) {
+        fs::create_directories(journalPath.parent_path());
+        trimTornTail(journalPath, sizeof(reflogRecord));
+        trimTornTail(indexPath, sizeof(reflogCheckpoint));
+        uint64_t n = count();
+
+        reflogRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        memcpy(rec.oldID, oldID.data(), min(oldID.size(), sizeof(rec.oldID)));
+        memcpy(rec.newID, newID.data(), min(newID.size(), sizeof(rec.newID)));
+        rec.time = (int64_t)time(nullptr);
+        rec.op = op;
+
+        reflogRecord last;
+        if (n > 0 && read(n - 1, last)) rec.time = max(rec.time, last.time);
+
+        {
+            ofstream out(journalPath, ios::binary | ios::app);
+            out.write(reinterpret_cast<const char*>(&rec), sizeof(rec));
+        }
+        if (n % REFLOG_STRIDE == 0) {
+            reflogCheckpoint cp = {rec.time, n};
+            ofstream out(indexPath, ios::binary | ios::app);
+            out.write(reinterpret_cast<const char*>(&cp), sizeof(cp));
+        }
+    }
+
+    /**
+     * Returns the commit HEAD pointed to at time `t`, or an empty string if
+     * the journal has no record that old.
+     */
+    string headAt(time_t t) {
+        vector<reflogCheckpoint> index = loadIndex();
+        auto it = upper_bound(index.begin(), index.end(), (int64_t)t,
+                              [](int64_t v, const reflogCheckpoint& cp) { return v < cp.time; });
+        if (it == index.begin()) return "";
+
+        // Scan at most one stride inside the checkpoint's block
+        uint64_t first = prev(it)->record;
+        uint64_t last = min(first + REFLOG_STRIDE, count());
+        string head;
+        for (uint64_t n = first; n < last; n++) {
+            reflogRecord rec;
+            if (!read(n, rec) || rec.time > (int64_t)t) break;
+            head = field(rec.newID);
+        }
+        return head;
+    }
+};
+
+/**
+ * Parses "YYYY/MM/DD HH:MM" in local time. Returns -1 on malformed input.
+ */
+time_t parse_time(const string& s) {
+    tm when = {};
+    if (sscanf(s.c_str(), "%d/%d/%d %d:%d", &when.tm_year, &when.tm_mon, &when.tm_mday,
+               &when.tm_hour, &when.tm_min) != 5) return -1;
+    when.tm_year -= 1900;
+    when.tm_mon -= 1;
+    when.tm_sec = 59;   // Minute resolution: include moves made during that minute
+    when.tm_isdst = -1;
+    return mktime(&when);
+}
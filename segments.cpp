@@ -0,0 +1,716 @@
+/**
+ * SEGMENTS.CPP
+ * Purpose: Packed storage of snapshot content. Distinct file contents (blobs,
+ * keyed by BLAKE3) are appended to segment files under .git/objects/, and each
+ * packed commit records a manifest mapping its paths to blob hashes. Segments
+ * are kept in a geometric sequence by size, so compaction only ever rewrites
+ * the small, recent end of the history. Archive segments hold the same kind of
+ * records with LZ-compressed content, for snapshots moved to cold storage.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <memory>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+#include "hash.cpp"
+#include "lz.cpp"
+#include "crc32c.cpp"
+#include "readahead.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// =============================================================================
+// ON-DISK FORMAT
+// .git/objects/segments       : live segments, oldest first ("<name> <bytes>" lines)
+// .git/objects/<name>.pack    : records of [32-byte hash][u64 length][content]
+//                               in archive segments ("arc-" names) content is
+//                               [u64 raw length][LZ stream]
+// .git/objects/<name>.idx     : segmentEntry array sorted by hash | u32 CRC32C
+// .git/objects/multi.idx      : combined index over all segments (see below)
+// .git/objects/lock           : flock held by the one process writing segments
+// .git/commits/<id>/manifest  : "<hash> <size> <path>" lines sorted by path
+// The segment list and manifests end with a CRC32C line (see crc32c.cpp).
+// =============================================================================
+
+const uint64_t SEGMENT_DEFAULT_FACTOR = 2;
+const char HOT_SEGMENT_PREFIX[] = "seg-";
+const char ARCHIVE_SEGMENT_PREFIX[] = "arc-";
+
+struct segmentEntry {
+    uint8_t hash[32];
+    uint64_t offset;        // Start of the content inside the pack
+    uint64_t length;
+};
+
+static_assert(sizeof(segmentEntry) == 48, "segment index layout must stay fixed");
+
+struct segmentInfo {
+    string name;
+    uint64_t bytes = 0;
+};
+
+bool hexToHash(const string& hex, uint8_t out[32]) {
+    if (hex.size() != 64) return false;
+    for (int i = 0; i < 32; i++) {
+        int hi = isdigit((unsigned char)hex[2 * i]) ? hex[2 * i] - '0' : (hex[2 * i] | 0x20) - 'a' + 10;
+        int lo = isdigit((unsigned char)hex[2 * i + 1]) ? hex[2 * i + 1] - '0' : (hex[2 * i + 1] | 0x20) - 'a' + 10;
+        if (hi < 0 || hi > 15 || lo < 0 || lo > 15) return false;
+        out[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+string hashToHex(const uint8_t hash[32]) {
+    static const char digits[] = "0123456789abcdef";
+    string hex(64, '0');
+    for (int i = 0; i < 32; i++) {
+        hex[2 * i] = digits[hash[i] >> 4];
+        hex[2 * i + 1] = digits[hash[i] & 15];
+    }
+    return hex;
+}
+
+inline bool entryBefore(const segmentEntry& a, const segmentEntry& b) {
+    return memcmp(a.hash, b.hash, 32) < 0;
+}
+
+inline bool isArchiveSegment(const string& name) {
+    return name.compare(0, 4, ARCHIVE_SEGMENT_PREFIX) == 0;
+}
+
+// =============================================================================
+// COMBINED INDEX FORMAT
+//   "MYMIDX1\n" | u32 segment count | fixed-width segment names
+//   | u64 entry count | combinedEntry array sorted by hash | u32 CRC32C
+// One binary search finds any blob no matter how many segments exist.
+// =============================================================================
+
+const char COMBINED_MAGIC[8] = {'M', 'Y', 'M', 'I', 'D', 'X', '1', '\n'};
+const size_t SEGMENT_NAME_LEN = 20;     // "seg-"/"arc-" + 16 hex digits
+
+struct combinedEntry {
+    uint8_t hash[32];
+    uint32_t segment;       // Position in the index's segment name table
+    uint32_t pad;
+    uint64_t offset;
+    uint64_t length;
+};
+
+static_assert(sizeof(combinedEntry) == 56, "combined index layout must stay fixed");
+
+inline bool combinedBefore(const combinedEntry& a, const combinedEntry& b) {
+    return memcmp(a.hash, b.hash, 32) < 0;
+}
+
+// =============================================================================
+// LOCKING
+// Every change to .git/objects (new segments, compaction, the segment list and
+// multi.idx) happens under an exclusive flock, so concurrent commits and
+// maintenance runs cannot pick the same segment name, overwrite each other's
+// list or delete a writer's in-progress files. Readers never take it.
+// =============================================================================
+
+#ifndef _WIN32
+class segmentLock {
+private:
+    int fd = -1;
+
+public:
+    explicit segmentLock(const fs::path& objectsDir) {
+        fd = open((objectsDir / "lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd >= 0) flock(fd, LOCK_EX);
+    }
+    ~segmentLock() { if (fd >= 0) close(fd); }
+    segmentLock(const segmentLock&) = delete;
+    segmentLock& operator=(const segmentLock&) = delete;
+};
+#else
+class segmentLock {
+public:
+    explicit segmentLock(const fs::path&) {}
+};
+#endif
+
+// =============================================================================
+// SEGMENT WRITER
+// Content goes to <name>.pack.tmp; finish() writes the index, syncs both and
+// renames them into place, so a crash never leaves a half-written segment in use.
+// Index entries always describe the stored (possibly compressed) bytes.
+// A writer from beginSegment() holds the segment lock until it is published
+// or dropped.
+// =============================================================================
+
+class segmentWriter {
+private:
+    fs::path dir;
+    string segName;
+    ofstream pack;
+    uint64_t written = 0;
+    vector<segmentEntry> entries;
+    set<string> added;
+    bool compressed;
+    unique_ptr<segmentLock> lock;
+
+    void header(const uint8_t hash[32], uint64_t length) {
+        pack.write(reinterpret_cast<const char*>(hash), 32);
+        pack.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        written += 32 + sizeof(length);
+    }
+
+public:
+    segmentWriter(const fs::path& objectsDir, const string& name, unique_ptr<segmentLock> held = nullptr)
+        : dir(objectsDir), segName(name), compressed(isArchiveSegment(name)), lock(move(held)) {
+        pack.open(dir / (segName + ".pack.tmp"), ios::binary | ios::trunc);
+    }
+
+    /**
+     * Hands the writer's lock to the caller, which publishes the segment under it.
+     */
+    unique_ptr<segmentLock> releaseLock() { return move(lock); }
+
+    const string& name() const { return segName; }
+    uint64_t bytes() const { return written; }
+    bool empty() const { return entries.empty(); }
+    bool has(const string& hex) const { return added.count(hex) > 0; }
+
+    void addBytes(const string& hex, const char* data, uint64_t length) {
+        if (has(hex)) return;
+        if (!compressed) {
+            addStored(hex, data, length);
+            return;
+        }
+        string stored(sizeof(length), '\0');
+        memcpy(&stored[0], &length, sizeof(length));
+        stored += lzCompress(data, length);
+        addStored(hex, stored.data(), stored.size());
+    }
+
+    /**
+     * Appends a record exactly as it is stored in a segment of the same kind
+     * (used when compaction copies records between segments).
+     */
+    void addStored(const string& hex, const char* data, uint64_t length) {
+        segmentEntry e;
+        if (has(hex) || !hexToHash(hex, e.hash)) return;
+        header(e.hash, length);
+        e.offset = written;
+        e.length = length;
+        pack.write(data, (streamsize)length);
+        written += length;
+        entries.push_back(e);
+        added.insert(hex);
+    }
+
+    /**
+     * Appends a file's content. The record header promises fs::file_size
+     * bytes, so a file that cannot be read in full is an error.
+     */
+    void addFile(const string& hex, const fs::path& src) {
+        segmentEntry e;
+        if (has(hex) || !hexToHash(hex, e.hash)) return;
+        ifstream in(src, ios::binary);
+        if (!in.is_open()) throw runtime_error("File Access Error");
+        if (compressed) {
+            string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            if (in.bad()) throw runtime_error("File Access Error");
+            addBytes(hex, content.data(), content.size());
+            return;
+        }
+        uint64_t length = fs::file_size(src);
+        header(e.hash, length);
+        e.offset = written;
+        e.length = length;
+
+        vector<char> buf(1 << 16);
+        uint64_t copied = 0;
+        while (copied < length) {
+            in.read(buf.data(), (streamsize)min<uint64_t>(buf.size(), length - copied));
+            if (in.gcount() <= 0) break;
+            pack.write(buf.data(), in.gcount());
+            copied += (uint64_t)in.gcount();
+        }
+        if (copied != length) throw runtime_error("File Access Error");
+        written += length;
+        entries.push_back(e);
+        added.insert(hex);
+    }
+
+    /**
+     * Writes the index and moves the segment into place. Returns false if
+     * either file could not be written or synced; nothing is renamed then.
+     */
+    bool finish() {
+        pack.close();
+        if (pack.fail()) return false;
+        sort(entries.begin(), entries.end(), entryBefore);
+        fs::path packTmp = dir / (segName + ".pack.tmp"), idxTmp = dir / (segName + ".idx.tmp");
+        {
+            ofstream idx(idxTmp, ios::binary | ios::trunc);
+            size_t size = entries.size() * sizeof(segmentEntry);
+            uint32_t crc = crc32c(entries.data(), size);
+            idx.write(reinterpret_cast<const char*>(entries.data()), (streamsize)size);
+            idx.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+            idx.close();
+            if (idx.fail()) return false;
+        }
+        if (!syncPath(packTmp) || !syncPath(idxTmp)) return false;
+
+        error_code ec;
+        fs::rename(idxTmp, dir / (segName + ".idx"), ec);
+        if (!ec) fs::rename(packTmp, dir / (segName + ".pack"), ec);
+        return !ec && syncPath(dir);
+    }
+
+    void abandon() {
+        pack.close();
+        error_code ec;
+        fs::remove(dir / (segName + ".pack.tmp"), ec);
+        fs::remove(dir / (segName + ".idx.tmp"), ec);
+        lock.reset();
+    }
+};
+
+// =============================================================================
+// SEGMENT STORE
+// =============================================================================
+
+class segmentStore {
+private:
+    fs::path dir = fs::path(".git") / "objects";
+    vector<segmentInfo> segments;                       // Oldest first
+    mutable map<string, vector<segmentEntry>> indexes;  // Loaded on first use
+    vector<string> combinedNames;                       // Segments covered by multi.idx
+    vector<combinedEntry> combined;
+
+    const vector<segmentEntry>& indexOf(const string& name) const {
+        auto it = indexes.find(name);
+        if (it != indexes.end()) return it->second;
+
+        vector<segmentEntry>& idx = indexes[name];
+        fs::path p = dir / (name + ".idx");
+        ifstream in(p, ios::binary);
+        if (in.is_open()) {
+            string raw((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            size_t payload = verifyRecordTrailer(p, raw.data(), raw.size(), sizeof(segmentEntry));
+            idx.resize(payload / sizeof(segmentEntry));
+            memcpy(idx.data(), raw.data(), payload);
+        }
+        return idx;
+    }
+
+    /**
+     * Re-reads the segment list and multi.idx; callers hold the segment lock,
+     * so another process's changes are seen before this one is applied.
+     */
+    void reload() {
+        string list;
+        segments.clear();
+        readSealedText(dir / "segments", list);
+        istringstream in(list);
+        segmentInfo s;
+        while (in >> s.name >> s.bytes) segments.push_back(s);
+        loadCombined();
+    }
+
+    // Callers hold the segment lock
+    void saveList() {
+        fs::create_directories(dir);
+        ostringstream out;
+        for (const auto& s : segments) out << s.name << " " << s.bytes << "\n";
+        if (!writeSealedText(dir / "segments", out.str(), true)) throw runtime_error("File Access Error");
+    }
+
+    /**
+     * Loads multi.idx. It only caches what the segment indexes say, so a
+     * damaged or truncated copy is ignored and rebuilt on the next refresh.
+     */
+    bool loadCombined() {
+        ifstream file(dir / "multi.idx", ios::binary);
+        string raw((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        const char* p = raw.data();
+        size_t left = raw.size();
+        auto take = [&](void* out, size_t n) {
+            if (left < n) return false;
+            memcpy(out, p, n);
+            p += n;
+            left -= n;
+            return true;
+        };
+
+        char magic[8];
+        uint32_t count = 0;
+        if (!take(magic, 8) || memcmp(magic, COMBINED_MAGIC, 8) != 0) return false;
+        if (!take(&count, sizeof(count)) || count > left / SEGMENT_NAME_LEN) return false;
+
+        vector<string> names(count);
+        for (auto& n : names) {
+            char buf[SEGMENT_NAME_LEN];
+            if (!take(buf, SEGMENT_NAME_LEN)) return false;
+            n.assign(buf, SEGMENT_NAME_LEN);
+        }
+        uint64_t entries = 0;
+        if (!take(&entries, sizeof(entries)) || entries > left / sizeof(combinedEntry)) return false;
+        vector<combinedEntry> loaded(entries);
+        if (!take(loaded.data(), entries * sizeof(combinedEntry))) return false;
+
+        uint32_t stored;
+        if (left == 0) {
+            if (checksumsRequired()) return false;
+        } else if (left != sizeof(stored) || !take(&stored, sizeof(stored)) ||
+                   crc32c(raw.data(), raw.size() - sizeof(stored)) != stored) {
+            return false;
+        }
+
+        combinedNames.swap(names);
+        combined.swap(loaded);
+        return true;
+    }
+
+    bool covered(const string& name) const {
+        return find(combinedNames.begin(), combinedNames.end(), name) != combinedNames.end();
+    }
+
+    /**
+     * Brings multi.idx in line with the live segment list without re-reading
+     * the segments it already covers: entries of retired segments are dropped,
+     * and the per-segment indexes of new segments are merged in.
+     */
+    void refreshCombined() {
+        vector<string> names;
+        vector<int> remap(combinedNames.size(), -1);
+        for (const auto& seg : segments) {
+            if (seg.name.size() != SEGMENT_NAME_LEN) continue;
+            auto it = find(combinedNames.begin(), combinedNames.end(), seg.name);
+            if (it != combinedNames.end()) remap[it - combinedNames.begin()] = (int)names.size();
+            names.push_back(seg.name);
+        }
+        if (names == combinedNames) return;
+
+        vector<combinedEntry> kept;
+        kept.reserve(combined.size());
+        for (const auto& e : combined) {
+            if (remap[e.segment] < 0) continue;
+            kept.push_back(e);
+            kept.back().segment = (uint32_t)remap[e.segment];
+        }
+
+        vector<combinedEntry> added;
+        for (uint32_t i = 0; i < names.size(); i++) {
+            if (covered(names[i])) continue;
+            for (const auto& e : indexOf(names[i])) {
+                combinedEntry c;
+                memcpy(c.hash, e.hash, 32);
+                c.segment = i;
+                c.pad = 0;
+                c.offset = e.offset;
+                c.length = e.length;
+                added.push_back(c);
+            }
+        }
+        sort(added.begin(), added.end(), combinedBefore);
+
+        combined.clear();
+        combined.reserve(kept.size() + added.size());
+        merge(kept.begin(), kept.end(), added.begin(), added.end(), back_inserter(combined), combinedBefore);
+        combinedNames.swap(names);
+
+        fs::path tmp = dir / "multi.idx.tmp";
+        {
+            ostringstream buf;
+            uint32_t count = (uint32_t)combinedNames.size();
+            uint64_t entries = combined.size();
+            buf.write(COMBINED_MAGIC, 8);
+            buf.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (const auto& n : combinedNames) buf.write(n.data(), SEGMENT_NAME_LEN);
+            buf.write(reinterpret_cast<const char*>(&entries), sizeof(entries));
+            string head = buf.str();
+
+            size_t size = entries * sizeof(combinedEntry);
+            uint32_t crc = crc32c(combined.data(), size, crc32c(head.data(), head.size()));
+            ofstream out(tmp, ios::binary | ios::trunc);
+            out.write(head.data(), (streamsize)head.size());
+            out.write(reinterpret_cast<const char*>(combined.data()), (streamsize)size);
+            out.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+        }
+        fs::rename(tmp, dir / "multi.idx");
+    }
+
+    /**
+     * Hot and archive segments share one sequence, so names stay unique and
+     * sort by age across both tiers. Callers hold the segment lock.
+     */
+    string nextName(const char* prefix) const {
+        uint64_t seq = 0;
+        error_code ec;
+        for (const auto& e : fs::directory_iterator(dir, ec)) {
+            string f = e.path().filename().string();
+            if (f.compare(0, 4, HOT_SEGMENT_PREFIX) == 0 || isArchiveSegment(f)) {
+                try { seq = max<uint64_t>(seq, stoull(f.substr(4, 16), nullptr, 16) + 1); }
+                catch (const exception&) {}
+            }
+        }
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%s%016llx", prefix, (unsigned long long)seq);
+        return buf;
+    }
+
+    /**
+     * Merges the newest segments of one tier (hot or archive) until every
+     * segment of that tier is at least `factor` times larger than all newer
+     * ones combined. Records are copied as stored, so archive content is never
+     * recompressed.
+     */
+    size_t compactTier(bool archive, uint64_t factor, const function<void(uint64_t)>& charge) {
+        vector<size_t> tier;
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (isArchiveSegment(segments[i].name) == archive) tier.push_back(i);
+        }
+        if (tier.size() < 2) return 0;
+
+        size_t first = tier.size() - 1;
+        uint64_t rolled = segments[tier.back()].bytes;
+        while (first > 0 && segments[tier[first - 1]].bytes < factor * rolled) {
+            first--;
+            rolled += segments[tier[first]].bytes;
+        }
+        if (first == tier.size() - 1) return 0;
+
+        segmentWriter w(dir, nextName(archive ? ARCHIVE_SEGMENT_PREFIX : HOT_SEGMENT_PREFIX));
+        set<string> mergedNames;
+        for (size_t k = first; k < tier.size(); k++) {
+            const segmentInfo& seg = segments[tier[k]];
+            // Packs are read front to back; start fetching the next one meanwhile
+            if (k + 1 < tier.size()) adviseWillNeed(dir / (segments[tier[k + 1]].name + ".pack"));
+            ifstream in(dir / (seg.name + ".pack"), ios::binary);
+            const auto& idx = indexOf(seg.name);
+
+            // A record that cannot be read back in full stops the merge; the inputs stay live
+            if (!in.is_open() || (idx.empty() && seg.bytes > 0)) {
+                w.abandon();
+                return 0;
+            }
+            string content;
+            for (const auto& e : idx) {
+                string hex = hashToHex(e.hash);
+                if (w.has(hex)) continue;
+                content.resize(e.length);
+                in.seekg((streamoff)e.offset);
+                if (!in.read(&content[0], (streamsize)e.length)) {
+                    w.abandon();
+                    return 0;
+                }
+                w.addStored(hex, content.data(), e.length);
+            }
+            if (charge) charge(2 * seg.bytes);
+            mergedNames.insert(seg.name);
+        }
+        if (!w.finish()) {
+            w.abandon();
+            return 0;
+        }
+
+        // Swap the merged run for the new segment; the old files go once the list naming it is synced
+        vector<segmentInfo> kept;
+        for (const auto& s : segments) if (!mergedNames.count(s.name)) kept.push_back(s);
+        kept.push_back({w.name(), w.bytes()});
+        segments.swap(kept);
+        saveList();
+        refreshCombined();
+
+        error_code ec;
+        for (const auto& m : mergedNames) {
+            fs::remove(dir / (m + ".pack"), ec);
+            fs::remove(dir / (m + ".idx"), ec);
+            indexes.erase(m);
+        }
+        return mergedNames.size();
+    }
+
+public:
+    segmentStore() { reload(); }
+
+    const vector<segmentInfo>& list() const { return segments; }
+
+    /**
+     * Updates the combined index for segments written before it existed.
+     */
+    void refreshIndex() {
+        fs::create_directories(dir);
+        segmentLock lock(dir);
+        reload();
+        refreshCombined();
+    }
+
+    /**
+     * Finds a blob with one binary search of the combined index. Segments it
+     * does not cover yet (written since the last refresh) are probed individually.
+     * With `archiveOnly`, copies in hot segments are ignored.
+     */
+    bool locate(const string& hex, string& segment, segmentEntry& entry, bool archiveOnly = false) const {
+        segmentEntry key;
+        if (!hexToHash(hex, key.hash)) return false;
+
+        combinedEntry probe;
+        memcpy(probe.hash, key.hash, 32);
+        auto range = equal_range(combined.begin(), combined.end(), probe, combinedBefore);
+        for (auto c = range.first; c != range.second; ++c) {
+            if (c->segment >= combinedNames.size()) continue;
+            const string& name = combinedNames[c->segment];
+            if (archiveOnly && !isArchiveSegment(name)) continue;
+            bool live = any_of(segments.begin(), segments.end(), [&](const segmentInfo& si) { return si.name == name; });
+            if (live) {
+                segment = name;
+                memcpy(entry.hash, c->hash, 32);
+                entry.offset = c->offset;
+                entry.length = c->length;
+                return true;
+            }
+        }
+
+        for (auto s = segments.rbegin(); s != segments.rend(); ++s) {
+            if (covered(s->name) || (archiveOnly && !isArchiveSegment(s->name))) continue;
+            const auto& idx = indexOf(s->name);
+            auto it = lower_bound(idx.begin(), idx.end(), key, entryBefore);
+            if (it != idx.end() && memcmp(it->hash, key.hash, 32) == 0) {
+                segment = s->name;
+                entry = *it;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool contains(const string& hex, bool archiveOnly = false) const {
+        string segment;
+        segmentEntry e;
+        return locate(hex, segment, e, archiveOnly);
+    }
+
+    /**
+     * Reads a blob's content, decompressing it if it lives in an archive segment.
+     */
+    bool read(const string& hex, string& content) const {
+        string segment;
+        segmentEntry e;
+        if (!locate(hex, segment, e)) return false;
+        ifstream in(dir / (segment + ".pack"), ios::binary);
+        content.resize(e.length);
+        in.seekg((streamoff)e.offset);
+        if (!in.read(&content[0], (streamsize)e.length) && e.length != 0) return false;
+        if (!isArchiveSegment(segment)) return true;
+
+        uint64_t raw;
+        if (e.length < sizeof(raw)) return false;
+        memcpy(&raw, content.data(), sizeof(raw));
+        string stored;
+        stored.swap(content);
+        return lzDecompress(stored.data() + sizeof(raw), stored.size() - sizeof(raw), raw, content);
+    }
+
+    /**
+     * Starts a new hot (or, with `archive`, compressed archive) segment. The
+     * writer holds the segment lock, so leftovers of interrupted writers can
+     * be discarded first: no other writer is running.
+     */
+    segmentWriter beginSegment(bool archive = false) {
+        fs::create_directories(dir);
+        unique_ptr<segmentLock> lock(new segmentLock(dir));
+        error_code ec;
+        for (const auto& e : fs::directory_iterator(dir, ec)) {
+            if (e.path().extension() == ".tmp") fs::remove(e.path(), ec);
+        }
+        return segmentWriter(dir, nextName(archive ? ARCHIVE_SEGMENT_PREFIX : HOT_SEGMENT_PREFIX), move(lock));
+    }
+
+    /**
+     * Publishes a finished writer as the newest segment and releases its lock.
+     */
+    void addSegment(segmentWriter& w) {
+        unique_ptr<segmentLock> lock = w.releaseLock();
+        if (w.empty()) {
+            w.abandon();
+            return;
+        }
+        if (!lock) lock.reset(new segmentLock(dir));
+        reload();
+        if (!w.finish()) {
+            w.abandon();
+            throw runtime_error("File Access Error");
+        }
+        segments.push_back({w.name(), w.bytes()});
+        saveList();
+        refreshCombined();
+    }
+
+    /**
+     * Restores the geometric invariant in each tier: every segment must be at
+     * least `factor` times larger than all newer segments of its tier combined.
+     * Only the newest segments that violate it are merged into one, so the
+     * large, old segments are never rewritten. `charge` is told how many bytes
+     * were copied. Returns the number of segments merged (0 if already geometric).
+     */
+    size_t compactGeometric(uint64_t factor, const function<void(uint64_t)>& charge = nullptr) {
+        fs::create_directories(dir);
+        segmentLock lock(dir);
+        reload();
+        return compactTier(false, factor, charge) + compactTier(true, factor, charge);
+    }
+};
+
+// =============================================================================
+// COMMIT MANIFESTS
+// =============================================================================
+
+struct manifestEntry {
+    string hash;
+    uintmax_t size = 0;
+};
+
+typedef map<string, manifestEntry> commitManifest;
+
+fs::path manifestPath(const string& commitID) {
+    return fs::path(".git") / "commits" / commitID / "manifest";
+}
+
+bool readManifest(const string& commitID, commitManifest& manifest) {
+    string content;
+    if (!readSealedText(manifestPath(commitID), content)) return false;
+
+    istringstream in(content);
+    string line;
+    while (getline(in, line)) {
+        size_t a = line.find(' '), b = line.find(' ', a + 1);
+        if (a == string::npos || b == string::npos) return false;
+        manifest[line.substr(b + 1)] = {line.substr(0, a), stoull(line.substr(a + 1, b - a - 1))};
+    }
+    return true;
+}
+
+/**
+ * With `durable` the manifest is synced before and after it is renamed into place.
+ */
+void writeManifest(const string& commitID, const commitManifest& manifest, bool durable = false) {
+    ostringstream out;
+    for (const auto& m : manifest) out << m.second.hash << " " << m.second.size << " " << m.first << "\n";
+    if (!writeSealedText(manifestPath(commitID), out.str(), durable)) throw runtime_error("File Access Error");
+}
+
+uint64_t segmentFactor() {
+    return max<uint64_t>(2, configSize("segment.factor", SEGMENT_DEFAULT_FACTOR));
+}
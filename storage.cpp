@@ -0,0 +1,386 @@
+/**
+ * STORAGE.CPP
+ * Purpose: Storage backends for commit snapshots. A backend is a plain class
+ * chosen at compile time (MYGIT_STORAGE_*), so snapshot writes and lookups are
+ * direct, inlinable calls with no virtual dispatch. Every backend reads every
+ * layout (Data/ trees and manifests), so a repository stays readable when a
+ * build with a different backend opens it; backends differ in how they write.
+ *
+ * Backend concept:
+ *   commit(id, parent, skip)      Start snapshot `id` with `parent`'s files except `skip`;
+ *                                 returns the inherited paths
+ *   put(id, path, src, immutable) Store `src` as `path` (`immutable` sources may be shared)
+ *   seal(id)                      Finish the snapshot; manifest backends also sync its
+ *                                 blobs and manifest to disk before returning
+ *   exists(id, path)              Whether the snapshot contains `path`
+ *   get(id, path)                 A readable file holding `path`
+ *   list(id)                      Every path of the snapshot and its readable file
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include "instrument.cpp"
+#include "segments.cpp"
+#include "readahead.cpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * Maps each relative path in a commit snapshot to a readable copy of its content.
+ */
+typedef map<string, fs::path> commitTree;
+
+fs::path snapshotDataPath(const string& commitID) {
+    return fs::current_path() / ".git" / "commits" / commitID / "Data";
+}
+
+/**
+ * Content-addressed loose object written by the loose-object backend.
+ */
+fs::path looseObjectPath(const string& hash) {
+    return fs::current_path() / ".git" / "objects" / "loose" / hash.substr(0, 2) / hash.substr(2);
+}
+
+/**
+ * An archived commit has moved from Data/ into archive segments; only its
+ * manifest is left in the commit directory.
+ */
+bool isArchived(const string& commitID) {
+    fs::path commitPath = fs::current_path() / ".git" / "commits" / commitID;
+    return !commitID.empty() && !fs::exists(commitPath / "Data") && fs::exists(commitPath / "manifest");
+}
+
+/**
+ * Returns a plain-file copy of a packed blob, extracting it on first use.
+ * The cache is content-addressed, so archived commits share one copy per content.
+ */
+fs::path materializeBlob(const segmentStore& store, const string& hash) {
+    fs::path cached = fs::current_path() / ".git" / "cache" / "blobs" / hash.substr(0, 2) / hash.substr(2);
+    if (fs::exists(cached)) return cached;
+
+    string content;
+    if (!store.read(hash, content)) throw runtime_error("Object " + hash + " is missing from the segment store");
+    fs::create_directories(cached.parent_path());
+
+    // log --stat workers may extract the same blob at once, so each writes its own tmp file
+    fs::path tmp = cached;
+    tmp += "." + to_string(getpid()) + "-" + to_string(std::hash<thread::id>()(this_thread::get_id()));
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        out.write(content.data(), (streamsize)content.size());
+        if (!out) throw runtime_error("File Access Error");
+    }
+
+    // Another thread may have published the blob first; its copy is identical
+    error_code ec;
+    fs::rename(tmp, cached, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        if (!fs::exists(cached)) throw runtime_error("File Access Error");
+    }
+    return cached;
+}
+
+// =============================================================================
+// READERS (shared by every backend)
+// =============================================================================
+
+class snapshotReader {
+private:
+    // Layout of the commit looked up last, so per-path lookups cost no extra stat
+    string cachedID;
+    bool cachedTree = false;
+    commitManifest cachedManifest;
+    unique_ptr<segmentStore> packed;
+
+    void load(const string& commitID) {
+        if (commitID == cachedID) return;
+        cachedID = commitID;
+        cachedManifest.clear();
+        cachedTree = fs::exists(snapshotDataPath(commitID));
+        if (!cachedTree) readManifest(commitID, cachedManifest);
+    }
+
+protected:
+    const segmentStore& segments() {
+        if (!packed) packed.reset(new segmentStore());
+        return *packed;
+    }
+
+    /**
+     * Readable copy of a blob: the loose object if there is one, else the
+     * extracted segment record.
+     */
+    fs::path blobPath(const string& hash) {
+        fs::path loose = looseObjectPath(hash);
+        if (fs::exists(loose)) return loose;
+        return materializeBlob(segments(), hash);
+    }
+
+    void forget(const string& commitID) {
+        if (commitID == cachedID) cachedID.clear();
+    }
+
+public:
+    bool exists(const string& commitID, const string& path) {
+        if (commitID.empty()) return false;
+        load(commitID);
+        if (cachedTree) return fs::exists(snapshotDataPath(commitID) / path);
+        return cachedManifest.count(path) > 0;
+    }
+
+    /**
+     * For Data/ trees the path is returned without a stat (it may not exist);
+     * for manifests an empty path means the snapshot has no such file.
+     */
+    fs::path get(const string& commitID, const string& path) {
+        if (commitID.empty()) return fs::path();
+        load(commitID);
+        if (cachedTree) return snapshotDataPath(commitID) / path;
+        auto m = cachedManifest.find(path);
+        return (m == cachedManifest.end()) ? fs::path() : blobPath(m->second.hash);
+    }
+
+    /**
+     * Lists the files stored in a commit snapshot. An empty ID yields an empty tree.
+     */
+    commitTree list(const string& commitID) {
+        commitTree tree;
+        if (commitID.empty()) return tree;
+        load(commitID);
+        memScope phase(PHASE_WALK, "readTree");
+
+        if (!cachedTree) {
+            for (const auto& m : cachedManifest) tree[m.first] = blobPath(m.second.hash);
+            return tree;
+        }
+        fs::path dataPath = snapshotDataPath(commitID);
+        for (const auto &e : fs::recursive_directory_iterator(dataPath)) {
+            if (e.is_regular_file()) tree[e.path().lexically_relative(dataPath).generic_string()] = e.path();
+        }
+        return tree;
+    }
+};
+
+// =============================================================================
+// DATA/ TREE BACKENDS
+// Every snapshot is a directory of files under .git/commits/<id>/Data.
+// `shareImmutable` = false copies every file (the original layout);
+// true hard-links files that are never modified in place, falling back to a copy.
+// =============================================================================
+
+template <bool shareImmutable>
+class dataTreeBackend : public snapshotReader {
+public:
+    static constexpr bool dataTrees = true;
+
+    vector<string> commit(const string& commitID, const string& parentID, const set<string>& skip) {
+        fs::create_directories(snapshotDataPath(commitID));
+        vector<string> paths;
+        if (parentID.empty()) return paths;
+
+        memScope phase(PHASE_COPY, "createCommit");
+        commitTree parent = list(parentID);
+
+        // Links only need the inodes, which are warmed a window ahead of the loop
+        vector<fs::path> sources;
+        for (const auto &t : parent) sources.push_back(t.second);
+        prefetcher ahead(move(sources), shareImmutable ? PREFETCH_INODE : PREFETCH_DATA, PREFETCH_WINDOW);
+
+        size_t n = 0;
+        for (const auto &t : parent) {
+            ahead.consumed(n++);
+            if (skip.count(t.first)) continue;
+            put(commitID, t.first, t.second, true);
+            paths.push_back(t.first);
+        }
+        return paths;
+    }
+
+    void put(const string& commitID, const string& path, const fs::path& src, bool immutable) {
+        fs::path dst = snapshotDataPath(commitID) / path;
+        {
+            latencyTimer t(LAT_MKDIR);
+            fs::create_directories(dst.parent_path());
+        }
+
+        // Ensure clean copy
+        bool exists;
+        {
+            latencyTimer t(LAT_STAT);
+            exists = fs::exists(dst);
+        }
+        if (exists) fs::remove(dst);
+
+        latencyTimer t(LAT_COPY);
+        if (shareImmutable && immutable) {
+            error_code ec;
+            fs::create_hard_link(src, dst, ec);
+            if (!ec) return;
+        }
+        fs::copy_file(src, dst);
+    }
+
+    // Data/ trees are left to the page cache; only the manifest layouts are synced
+    void seal(const string& commitID) { forget(commitID); }
+};
+
+typedef dataTreeBackend<false> legacyCopyBackend;
+typedef dataTreeBackend<true> hardlinkBackend;
+
+// =============================================================================
+// MANIFEST BACKENDS
+// A snapshot is only a manifest (path -> content hash); each distinct content
+// is stored once by the blob sink. Inheriting from a manifest parent copies
+// its entries without touching file content.
+// =============================================================================
+
+/**
+ * One file per content under .git/objects/loose/<hh>/<rest>.
+ */
+class looseObjectSink {
+private:
+    // Objects written since the last flush, synced together with their directories
+    vector<fs::path> written;
+
+public:
+    void add(const string& hash, const fs::path& src, bool immutable) {
+        fs::path dst = looseObjectPath(hash);
+        {
+            latencyTimer t(LAT_STAT);
+            if (fs::exists(dst)) return;
+        }
+        {
+            latencyTimer t(LAT_MKDIR);
+            fs::create_directories(dst.parent_path());
+        }
+
+        latencyTimer t(LAT_COPY);
+        written.push_back(dst);
+        error_code ec;
+        if (immutable) {
+            fs::create_hard_link(src, dst, ec);
+            if (!ec) return;
+        }
+        fs::path tmp = dst;
+        tmp += "." + to_string(getpid());
+        fs::copy_file(src, tmp, fs::copy_options::overwrite_existing);
+        fs::rename(tmp, dst);
+    }
+
+    void flush() {
+        set<fs::path> dirs;
+        for (const auto& p : written) {
+            if (!syncPath(p)) throw runtime_error("File Access Error");
+            dirs.insert(p.parent_path());
+            dirs.insert(p.parent_path().parent_path());
+        }
+        for (const auto& d : dirs) {
+            if (!syncPath(d)) throw runtime_error("File Access Error");
+        }
+        written.clear();
+    }
+};
+
+/**
+ * New contents of a commit are appended to one hot segment, published when
+ * the commit is sealed and then compacted geometrically.
+ */
+class segmentSink {
+private:
+    segmentStore store;
+    unique_ptr<segmentWriter> writer;
+
+public:
+    void add(const string& hash, const fs::path& src, bool) {
+        if ((writer && writer->has(hash)) || store.contains(hash)) return;
+        if (!writer) writer.reset(new segmentWriter(store.beginSegment()));
+        latencyTimer t(LAT_COPY);
+        writer->addFile(hash, src);
+    }
+
+    void flush() {
+        if (!writer) return;
+        store.addSegment(*writer);
+        writer.reset();
+        store.compactGeometric(segmentFactor());
+    }
+};
+
+template <class blobSink>
+class manifestBackend : public snapshotReader {
+private:
+    blobSink sink;
+    commitManifest pending;
+
+public:
+    static constexpr bool dataTrees = false;
+
+    vector<string> commit(const string& commitID, const string& parentID, const set<string>& skip) {
+        fs::create_directories(manifestPath(commitID).parent_path());
+        pending.clear();
+        vector<string> paths;
+        if (parentID.empty()) return paths;
+
+        memScope phase(PHASE_COPY, "createCommit");
+        commitManifest parent;
+        if (readManifest(parentID, parent)) {
+            for (const auto& m : parent) {
+                if (skip.count(m.first)) continue;
+                pending.insert(m);
+                paths.push_back(m.first);
+            }
+            return paths;
+        }
+
+        // Parent written by a Data/ backend: its files have to be hashed once
+        for (const auto& t : list(parentID)) {
+            if (skip.count(t.first)) continue;
+            put(commitID, t.first, t.second, true);
+            paths.push_back(t.first);
+        }
+        return paths;
+    }
+
+    void put(const string&, const string& path, const fs::path& src, bool immutable) {
+        error_code ec;
+        manifestEntry entry = {hashFile(src), fs::file_size(src, ec)};
+        sink.add(entry.hash, src, immutable);
+        pending[path] = entry;
+    }
+
+    void seal(const string& commitID) {
+        sink.flush();
+        writeManifest(commitID, pending, true);
+        pending.clear();
+        forget(commitID);
+    }
+};
+
+typedef manifestBackend<looseObjectSink> looseObjectBackend;
+typedef manifestBackend<segmentSink> segmentBackend;
+
+// =============================================================================
+// BACKEND SELECTION
+// =============================================================================
+
+#if defined(MYGIT_STORAGE_COPY)
+typedef legacyCopyBackend snapshotBackend;
+#elif defined(MYGIT_STORAGE_LOOSE)
+typedef looseObjectBackend snapshotBackend;
+#elif defined(MYGIT_STORAGE_SEGMENT)
+typedef segmentBackend snapshotBackend;
+#else
+typedef hardlinkBackend snapshotBackend;
+#endif